@@ -0,0 +1,378 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "src/batch.h"
+#include "src/deco.h"
+#include "src/kernel.h"
+#include "src/pool.h"
+#include "src/replay.h"
+#include "src/schedule.h"
+
+#define ITERATIONS 1000000
+#define BATCH_PLANS 64
+
+typedef struct bench_t {
+    const char *name;
+    double (*fn)(decostate_t *ds, const gas_t *gas, int iterations);
+    int iterations;
+} bench_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1E9;
+}
+
+static double bench_ceiling(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += ceiling(ds, 30 + (i & 63));
+
+    return sink;
+}
+
+static double bench_ceilings(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double gf[19];
+    double c[len(gf)];
+
+    for (int j = 0; j < (int) len(gf); j++)
+        gf[j] = 10 + 5 * j;
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i += len(gf)) {
+        ceilings(ds, gf, len(gf), c);
+        sink += c[0];
+    }
+
+    return sink;
+}
+
+static double bench_gf99(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += gf99(ds, abs_depth(NULL, msw_to_bar(i & 31)));
+
+    return sink;
+}
+
+static double bench_segment_const(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += add_segment_const(ds, abs_depth(NULL, msw_to_bar(i & 31)), 1, gas);
+
+    return sink;
+}
+
+static double bench_segment_nitrox(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    const gas_t ean32 = gas_new(NULL, 32, 0, MOD_AUTO);
+
+    double sink = 0;
+
+    /* fresh tissues, the loaded ones carry helium */
+    decostate_t ds_;
+    init_decostate(&ds_, ds->conf);
+
+    for (int i = 0; i < iterations; i++)
+        sink += add_segment_const(&ds_, abs_depth(NULL, msw_to_bar(i & 31)), 1, &ean32);
+
+    return sink;
+}
+
+static double bench_segment_uncached(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    /* durations the model and plan config keep no propagator for */
+    for (int i = 0; i < iterations; i++)
+        sink += add_segment_const(ds, abs_depth(NULL, msw_to_bar(i & 31)), 1 + (i & 1023) / 1000.0, gas);
+
+    return sink;
+}
+
+static double bench_segment_ascdec(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += add_segment_ascdec(ds, abs_depth(NULL, msw_to_bar(i & 31)), abs_depth(NULL, msw_to_bar(16)), 0.5, gas);
+
+    return sink;
+}
+
+static double bench_segment_op(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    /* a bottom phase of 32 levels, composed once and applied as a single operator */
+    segment_op_t op;
+    segment_op_identity(&op);
+
+    for (int i = 0; i < 32; i++) {
+        segment_op_t level;
+        segment_op_const(&level, ds->conf->model, abs_depth(NULL, msw_to_bar(i)), 1, gas);
+        segment_op_compose(&op, &op, &level);
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        apply_segment_op(ds, &op);
+        sink += ds->tissues.pn2[0];
+    }
+
+    return sink;
+}
+
+static const gas_t *bench_gasses(void)
+{
+    static gas_t gasses[GAS_SCHEDULE_GASSES];
+
+    for (int i = 0; i < GAS_SCHEDULE_GASSES; i++)
+        gasses[i] = gas_new(NULL, 100 - 10 * i, 0, MOD_AUTO);
+
+    return gasses;
+}
+
+static double bench_best_gas(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    const gas_t *gasses = bench_gasses();
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += gas_mod(best_gas(abs_depth(NULL, msw_to_bar(3 * (i & 7))), gasses, GAS_SCHEDULE_GASSES));
+
+    return sink;
+}
+
+static double bench_gas_schedule(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    gas_schedule_t schedule;
+    init_gas_schedule(&schedule, ds->conf, bench_gasses(), GAS_SCHEDULE_GASSES);
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += gas_mod(gas_schedule_best(&schedule, abs_depth(NULL, msw_to_bar(3 * (i & 7)))));
+
+    return sink;
+}
+
+static double bench_calc_deco(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+    const double depth = abs_depth(NULL, msw_to_bar(60));
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        decostate_t ds_ = *ds;
+        sink += calc_deco(&ds_, depth, gas, deco_gasses, len(deco_gasses), NULL).tts;
+    }
+
+    return sink;
+}
+
+/* one call per plan, evaluated in batches of BATCH_PLANS plans */
+static double bench_batch_ceiling(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double gf[BATCH_PLANS];
+    double c[BATCH_PLANS];
+
+    decostate_batch_t b;
+
+    if (init_decostate_batch(&b, ds->conf, BATCH_PLANS))
+        return 0;
+
+    for (int j = 0; j < BATCH_PLANS; j++) {
+        batch_set_plan(&b, j, ds);
+        gf[j] = 30 + (j & 63);
+    }
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i += BATCH_PLANS) {
+        batch_ceiling(&b, gf, c);
+        sink += c[0];
+    }
+
+    free_decostate_batch(&b);
+
+    return sink;
+}
+
+static double bench_batch_calc_deco(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    double depth[BATCH_PLANS];
+    const gas_t *gasses[BATCH_PLANS];
+    decoinfo_t ret[BATCH_PLANS];
+
+    for (int j = 0; j < BATCH_PLANS; j++) {
+        depth[j] = abs_depth(NULL, msw_to_bar(60));
+        gasses[j] = gas;
+    }
+
+    decostate_batch_t b;
+
+    if (init_decostate_batch(&b, ds->conf, BATCH_PLANS))
+        return 0;
+
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i += BATCH_PLANS) {
+        for (int j = 0; j < BATCH_PLANS; j++)
+            batch_set_plan(&b, j, ds);
+
+        batch_calc_deco(&b, depth, gasses, deco_gasses, len(deco_gasses), ret);
+        sink += ret[0].tts;
+    }
+
+    free_decostate_batch(&b);
+
+    return sink;
+}
+
+/* one call per sample of a per-second log, replayed on every cpu */
+static double bench_replay(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    waypoint_t *waypoints = malloc(iterations * sizeof(waypoint_t));
+    replay_sample_t *samples = malloc(iterations * sizeof(replay_sample_t));
+    pool_t *pool = pool_new(0);
+
+    double sink = 0;
+
+    if (waypoints && samples && pool) {
+        for (int i = 0; i < iterations; i++) {
+            waypoints[i].depth = abs_depth(NULL, msw_to_bar(40 + (i / 60) % 7));
+            waypoints[i].time = 1 / 60.0;
+            waypoints[i].gas = gas;
+        }
+
+        decostate_t ds_;
+        init_decostate(&ds_, ds->conf);
+
+        replay_dive(&ds_, waypoints, iterations, samples, pool);
+        sink = samples[iterations - 1].ceiling;
+    }
+
+    pool_free(pool);
+    free(samples);
+    free(waypoints);
+
+    return sink;
+}
+
+static double bench_direct_ascent(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    double sink = 0;
+
+    for (int i = 0; i < iterations; i++)
+        sink += direct_ascent(ds, abs_depth(NULL, msw_to_bar(9 + (i & 31))), 1 + (i & 31) / 9.0, gas);
+
+    return sink;
+}
+
+static double bench_calc_ndl(decostate_t *ds, const gas_t *gas, int iterations)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    double sink = 0;
+
+    /* fresh tissues, the loaded ones have no ndl left */
+    decostate_t ds_;
+    init_decostate(&ds_, ds->conf);
+
+    for (int i = 0; i < iterations; i++)
+        sink += calc_ndl(&ds_, abs_depth(NULL, msw_to_bar(12 + (i & 15))), msw_to_bar(9), &air);
+
+    return sink;
+}
+
+static const bench_t BENCHES[] = {
+    {"ceiling",          &bench_ceiling,          ITERATIONS       },
+    {"ceilings",         &bench_ceilings,         ITERATIONS       },
+    {"batch_ceiling",    &bench_batch_ceiling,    ITERATIONS       },
+    {"gf99",             &bench_gf99,             ITERATIONS       },
+    {"segment_const",    &bench_segment_const,    ITERATIONS       },
+    {"segment_nitrox",   &bench_segment_nitrox,   ITERATIONS       },
+    {"segment_uncached", &bench_segment_uncached, ITERATIONS       },
+    {"segment_ascdec",   &bench_segment_ascdec,   ITERATIONS       },
+    {"segment_op",       &bench_segment_op,       ITERATIONS       },
+    {"best_gas",         &bench_best_gas,         ITERATIONS       },
+    {"gas_schedule",     &bench_gas_schedule,     ITERATIONS       },
+    {"calc_deco",        &bench_calc_deco,        ITERATIONS / 1000},
+    {"batch_calc_deco",  &bench_batch_calc_deco,  ITERATIONS / 1000},
+    {"direct_ascent",    &bench_direct_ascent,    ITERATIONS       },
+    {"calc_ndl",         &bench_calc_ndl,         ITERATIONS / 1000},
+    {"replay",           &bench_replay,           ITERATIONS / 10  },
+};
+
+static const char *KERNEL_NAMES[] = {
+    [KERNEL_SCALAR] = "scalar",
+    [KERNEL_SSE2] = "sse2",
+    [KERNEL_AVX2] = "avx2",
+};
+
+int main(int argc, const char *argv[])
+{
+    const gas_t gas = gas_new(NULL, 18, 45, MOD_AUTO);
+
+    printf("%-16s %-8s %12s %8s\n", "benchmark", "kernel", "ns/call", "speedup");
+
+    for (int b = 0; b < (int) len(BENCHES); b++) {
+        double ns_scalar = 0;
+
+        for (enum KERNEL kernel = KERNEL_SCALAR; kernel <= KERNEL_AVX2; kernel++) {
+            if (kernel_select(kernel) != kernel)
+                continue;
+
+            /* every kernel starts from a fresh model and the same loaded tissue state */
+            opendeco_ctx *ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+
+            if (!ctx)
+                return 1;
+
+            decoconf_t conf;
+            init_decoconf(&conf, ctx, 30, 75, msw_to_bar(3));
+
+            decostate_t ds;
+            init_decostate(&ds, &conf);
+            add_segment_const(&ds, abs_depth(NULL, msw_to_bar(60)), 30, &gas);
+
+            double start = now();
+            volatile double sink = BENCHES[b].fn(&ds, &gas, BENCHES[b].iterations);
+            double ns = (now() - start) / BENCHES[b].iterations * 1E9;
+
+            (void) sink;
+
+            if (kernel == KERNEL_SCALAR)
+                ns_scalar = ns;
+
+            printf("%-16s %-8s %12.2f %7.2fx\n", BENCHES[b].name, KERNEL_NAMES[kernel], ns, ns_scalar / ns);
+
+            opendeco_ctx_free(ctx);
+        }
+    }
+
+    return 0;
+}
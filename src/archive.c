@@ -0,0 +1,330 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "archive.h"
+#include "divelog.h"
+
+typedef struct path_list_t {
+    char **paths;
+    int n;
+    int size;
+} path_list_t;
+
+static int push_path(path_list_t *list, char *path)
+{
+    if (!path)
+        return -1;
+
+    if (list->n == list->size) {
+        int size = max(64, 2 * list->size);
+        char **paths = realloc(list->paths, size * sizeof(char *));
+
+        if (!paths) {
+            free(path);
+            return -1;
+        }
+
+        list->paths = paths;
+        list->size = size;
+    }
+
+    list->paths[list->n++] = path;
+    return 0;
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static int list_dir(path_list_t *list, const char *dir)
+{
+    DIR *d = opendir(dir);
+
+    if (!d)
+        return -1;
+
+    struct dirent *entry;
+    int ret = 0;
+
+    while (!ret && (entry = readdir(d))) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        char *path = malloc(strlen(dir) + strlen(entry->d_name) + 2);
+
+        if (!path) {
+            ret = -1;
+            break;
+        }
+
+        sprintf(path, "%s/%s", dir, entry->d_name);
+
+        struct stat st;
+
+        if (stat(path, &st) || !S_ISREG(st.st_mode)) {
+            free(path);
+            continue;
+        }
+
+        ret = push_path(list, path);
+    }
+
+    closedir(d);
+
+    /* readdir() order depends on the filesystem */
+    if (!ret)
+        qsort(list->paths, list->n, sizeof(char *), &compare_paths);
+
+    return ret;
+}
+
+static int list_file(path_list_t *list, FILE *file)
+{
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t n;
+    int ret = 0;
+
+    while (!ret && (n = getline(&line, &size, file)) >= 0) {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+            line[--n] = '\0';
+
+        if (!n || line[0] == '#')
+            continue;
+
+        ret = push_path(list, strdup(line));
+    }
+
+    free(line);
+
+    return ret || ferror(file) ? -1 : 0;
+}
+
+/*
+ * The logs of an archive: every regular file in the directory path sorted by
+ * name, or else the paths listed one per line in the file path, in order.
+ * A path of - reads the list from stdin. Returns the number of logs, or -1 if
+ * path cannot be read or memory cannot be allocated.
+ */
+int list_archive(char ***paths, const char *path)
+{
+    path_list_t list = {0};
+    struct stat st;
+    int ret;
+
+    if (!strcmp(path, "-")) {
+        ret = list_file(&list, stdin);
+    } else if (!stat(path, &st) && S_ISDIR(st.st_mode)) {
+        ret = list_dir(&list, path);
+    } else {
+        FILE *file = fopen(path, "r");
+        ret = file ? list_file(&list, file) : -1;
+
+        if (file)
+            fclose(file);
+    }
+
+    if (ret) {
+        free_archive_list(list.paths, list.n);
+        *paths = NULL;
+        return -1;
+    }
+
+    *paths = list.paths;
+    return list.n;
+}
+
+void free_archive_list(char **paths, int nof_paths)
+{
+    for (int i = 0; i < nof_paths; i++)
+        free(paths[i]);
+
+    free(paths);
+}
+
+typedef struct archive_job_t {
+    log_archive_t *archive;
+    const decoconf_t *conf;
+    const gas_t *gas;
+    double tolerance;
+    const profile_file_t *pf;
+} archive_job_t;
+
+static void summarize_sample(const decostate_t *ds, const log_sample_t *sample, void *arg)
+{
+    dive_summary_t *dive = arg;
+
+    dive->runtime = sample->time;
+    dive->max_depth = max(dive->max_depth, sample->depth);
+    dive->max_gf99 = max(dive->max_gf99, sample->gf99);
+    dive->max_violation = max(dive->max_violation, sample->ceiling - sample->depth);
+    dive->surf_gf = sample->surf_gf;
+    dive->compartment = sample->compartment;
+}
+
+static void summarize_waypoint(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    dive_summary_t *dive = arg;
+
+    log_sample_t sample;
+    init_log_sample(&sample, ds, dive->runtime + wp.time, wp.depth, wp.gas);
+
+    summarize_sample(ds, &sample, dive);
+}
+
+static void analyze_dive(void *arg, int i)
+{
+    archive_job_t *job = arg;
+    dive_summary_t *dive = &job->archive->dives[i];
+
+    FILE *file = fopen(dive->path, "r");
+    divelog_t log;
+
+    if (!file || init_divelog(&log, file, job->conf->ctx, job->gas)) {
+        dive->status = DIVE_UNREADABLE;
+
+        if (file)
+            fclose(file);
+
+        return;
+    }
+
+    log.tolerance = job->tolerance;
+
+    decostate_t ds;
+    init_decostate(&ds, job->conf);
+
+    log_callback_t cb = {
+        .fn = &summarize_sample,
+        .arg = dive,
+    };
+
+    dive->nof_samples = replay_log(&ds, &log, &cb, NULL);
+
+    if (dive->nof_samples < 0) {
+        dive->status = DIVE_INVALID;
+        dive->line = log.line;
+        dive->nof_samples = log.nof_samples;
+    }
+
+    dive->nof_segments = log.nof_segments;
+    dive->tissues = ds.tissues;
+
+    free_divelog(&log);
+    fclose(file);
+}
+
+static int init_log_archive(log_archive_t *archive, const decoconf_t *conf, int nof_dives)
+{
+    archive->nof_dives = nof_dives;
+
+    if (posix_memalign((void **) &archive->dives, 64, max(1, nof_dives) * sizeof(dive_summary_t)))
+        return -1;
+
+    for (int i = 0; i < nof_dives; i++) {
+        archive->dives[i] = (dive_summary_t){
+            .status = DIVE_OK,
+            .max_depth = abs_depth(conf->ctx, 0),
+        };
+
+        init_tissues(&archive->dives[i].tissues, conf->ctx);
+    }
+
+    return 0;
+}
+
+/*
+ * Replay every log in paths on gas and summarize it: the maximum depth and
+ * gf99, the most the diver has been above the ceiling and the tissues at the
+ * end of the dive. A positive tolerance decimates every log first, see
+ * decimate_dive(). Logs are claimed one at a time by the threads of the pool,
+ * so long and short logs balance out, and every replay streams its log with
+ * a decostate of its own. Summaries are stored in the order of paths, which
+ * must outlive the archive. Returns -1 if memory cannot be allocated.
+ */
+int analyze_archive(log_archive_t *archive, const decoconf_t *conf, const gas_t *gas, char *const *paths,
+                    int nof_paths, double tolerance, pool_t *pool)
+{
+    if (init_log_archive(archive, conf, nof_paths))
+        return -1;
+
+    for (int i = 0; i < nof_paths; i++)
+        archive->dives[i].path = paths[i];
+
+    archive_job_t job = {
+        .archive = archive,
+        .conf = conf,
+        .gas = gas,
+        .tolerance = tolerance,
+    };
+
+    pool_for(pool, nof_paths, &analyze_dive, &job);
+
+    return 0;
+}
+
+static void analyze_profile_dive(void *arg, int i)
+{
+    archive_job_t *job = arg;
+    dive_summary_t *dive = &job->archive->dives[i];
+
+    const packed_waypoint_t *waypoints;
+    int n = profile_dive(job->pf, i, &waypoints);
+
+    if (n < 0) {
+        dive->status = n == -2 ? DIVE_INVALID : DIVE_UNREADABLE;
+        return;
+    }
+
+    decostate_t ds;
+    init_decostate(&ds, job->conf);
+
+    waypoint_callback_t cb = {
+        .fn = &summarize_waypoint,
+        .arg = dive,
+    };
+
+    /* straight from the mapping */
+    simulate_dive_packed(&ds, &job->pf->gasses, waypoints, n, &cb);
+
+    dive->nof_samples = n;
+    dive->nof_segments = n;
+    dive->tissues = ds.tissues;
+}
+
+/*
+ * Summarize every dive of the profile container pf like analyze_archive()
+ * summarizes logs, replaying the packed segments where they are mapped.
+ * Returns -1 if the depths of pf were converted at a surface pressure other
+ * than that of conf, see profile_surface_matches(), or if memory cannot be
+ * allocated.
+ */
+int analyze_profile(log_archive_t *archive, const decoconf_t *conf, const profile_file_t *pf, pool_t *pool)
+{
+    if (!profile_surface_matches(pf, conf->ctx) || init_log_archive(archive, conf, pf->nof_dives))
+        return -1;
+
+    archive_job_t job = {
+        .archive = archive,
+        .conf = conf,
+        .pf = pf,
+    };
+
+    pool_for(pool, pf->nof_dives, &analyze_profile_dive, &job);
+
+    return 0;
+}
+
+void free_log_archive(log_archive_t *archive)
+{
+    free(archive->dives);
+
+    archive->dives = NULL;
+    archive->nof_dives = 0;
+}
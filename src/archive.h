@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "deco.h"
+#include "pool.h"
+#include "profile.h"
+
+/* types */
+enum DIVE_STATUS {
+    DIVE_OK,
+    DIVE_UNREADABLE, /* the log could not be opened or allocated */
+    DIVE_INVALID,    /* the log has an invalid sample, or the profile dive an invalid segment */
+};
+
+typedef struct dive_summary_t {
+    const char *path; /* NULL for the dives of a profile container */
+    enum DIVE_STATUS status;
+    int line; /* of the invalid sample */
+
+    int nof_samples;
+    int nof_segments; /* fewer than nof_samples if the log was decimated */
+    double runtime;   /* of the last sample in minutes */
+    double max_depth; /* absolute pressure */
+    double max_gf99;
+    double max_violation; /* the most the diver has been above the ceiling at gfhi, in bar */
+    double surf_gf;       /* at the end of the dive */
+    int compartment;      /* that controls the ceiling at the end of the dive */
+    tissues_t tissues;    /* at the end of the dive */
+} dive_summary_t;
+
+typedef struct log_archive_t {
+    int nof_dives;
+    dive_summary_t *dives; /* in the order of the paths */
+} log_archive_t;
+
+/* functions */
+int list_archive(char ***paths, const char *path);
+void free_archive_list(char **paths, int nof_paths);
+
+int analyze_archive(log_archive_t *archive, const decoconf_t *conf, const gas_t *gas, char *const *paths,
+                    int nof_paths, double tolerance, pool_t *pool);
+int analyze_profile(log_archive_t *archive, const decoconf_t *conf, const profile_file_t *pf, pool_t *pool);
+void free_log_archive(log_archive_t *archive);
+
+#endif /* end of include guard: ARCHIVE_H */
@@ -0,0 +1,540 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+
+enum LANE_STATE {
+    LANE_ASCENT,
+    LANE_STOP,
+    LANE_STEP,
+    LANE_DONE,
+};
+
+typedef struct lane_t {
+    enum LANE_STATE state;
+    double depth;
+    const gas_t *gas;
+    double next_stop;
+    double current_gf;
+} lane_t;
+
+int init_decostate_batch(decostate_batch_t *b, const decoconf_t *conf, int nof_plans)
+{
+    assert(nof_plans > 0);
+
+    const int stride = (nof_plans + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+
+    /* four compartment-major blocks followed by nine per plan rows */
+    const size_t size = (4 * 16 + 9) * stride * sizeof(double);
+
+    if (posix_memalign(&b->mem, 64, size))
+        return -1;
+
+    memset(b->mem, 0, size);
+
+    double *mem = b->mem;
+
+    b->conf = conf;
+    b->nof_plans = nof_plans;
+    b->stride = stride;
+
+    b->phe = mem;
+    b->pn2 = mem + 16 * stride;
+    b->e_he = mem + 32 * stride;
+    b->e_n2 = mem + 48 * stride;
+    b->pio_he = mem + 64 * stride;
+    b->pio_n2 = mem + 65 * stride;
+    b->r_he = mem + 66 * stride;
+    b->r_n2 = mem + 67 * stride;
+    b->time = mem + 68 * stride;
+    b->asc = mem + 69 * stride;
+    b->firststop = mem + 70 * stride;
+    b->max_depth = mem + 71 * stride;
+    b->he_loaded = mem + 72 * stride;
+
+    /* the padding lanes hold surface tissues and stay masked out with a time of 0 */
+    decostate_t ds;
+    init_decostate(&ds, conf);
+
+    for (int j = 0; j < stride; j++)
+        batch_set_plan(b, j, &ds);
+
+    return 0;
+}
+
+void free_decostate_batch(decostate_batch_t *b)
+{
+    free(b->mem);
+    b->mem = NULL;
+}
+
+void batch_set_plan(decostate_batch_t *b, int plan, const decostate_t *ds)
+{
+    assert(ds->conf->model == b->conf->model);
+
+    for (int i = 0; i < 16; i++) {
+        b->phe[i * b->stride + plan] = ds->tissues.phe[i];
+        b->pn2[i * b->stride + plan] = ds->tissues.pn2[i];
+    }
+
+    b->firststop[plan] = ds->firststop;
+    b->max_depth[plan] = ds->max_depth;
+    b->he_loaded[plan] = ds->tissues.he_loaded;
+}
+
+void batch_get_plan(const decostate_batch_t *b, int plan, decostate_t *ds)
+{
+    for (int i = 0; i < 16; i++) {
+        ds->tissues.phe[i] = b->phe[i * b->stride + plan];
+        ds->tissues.pn2[i] = b->pn2[i * b->stride + plan];
+    }
+
+    ds->tissues.he_loaded = b->he_loaded[plan] != 0;
+
+    ds->conf = b->conf;
+    ds->firststop = b->firststop[plan];
+    ds->max_depth = b->max_depth[plan];
+}
+
+static void lane_mask(decostate_batch_t *b, int j)
+{
+    b->pio_he[j] = 0;
+    b->pio_n2[j] = 0;
+    b->r_he[j] = 0;
+    b->r_n2[j] = 0;
+    b->time[j] = 0;
+    b->asc[j] = 0;
+}
+
+/* same parameters as tissues_add_segment_ascdec(), applied by batch_segment() */
+static void lane_segment_ascdec(decostate_batch_t *b, int j, double dstart, double dend, double time,
+                                const gas_t *gas)
+{
+    assert(time > 0);
+
+    const double p_wv = b->conf->model->p_wv;
+    const double rate = (dend - dstart) / time;
+
+    b->pio_he[j] = gas_he(gas) / 100.0 * (dstart - p_wv);
+    b->pio_n2[j] = gas_n2(gas) / 100.0 * (dstart - p_wv);
+    b->r_he[j] = gas_he(gas) / 100.0 * rate;
+    b->r_n2[j] = gas_n2(gas) / 100.0 * rate;
+    b->time[j] = time;
+    b->asc[j] = 1;
+
+    if (gas_he(gas))
+        b->he_loaded[j] = 1;
+
+    if (dend > b->max_depth[j])
+        b->max_depth[j] = dend;
+}
+
+/* same parameters as tissues_add_segment_const(), applied by batch_segment() */
+static void lane_segment_const(decostate_batch_t *b, int j, double depth, double time, const gas_t *gas)
+{
+    assert(time > 0);
+
+    const double p_wv = b->conf->model->p_wv;
+
+    b->pio_he[j] = gas_he(gas) / 100.0 * (depth - p_wv);
+    b->pio_n2[j] = gas_n2(gas) / 100.0 * (depth - p_wv);
+    b->r_he[j] = 0;
+    b->r_n2[j] = 0;
+    b->time[j] = time;
+    b->asc[j] = 0;
+
+    if (gas_he(gas))
+        b->he_loaded[j] = 1;
+
+    if (depth > b->max_depth[j])
+        b->max_depth[j] = depth;
+}
+
+/*
+ * Update one compartment of every plan. Both updates are calculated for every
+ * lane with a fixed trip count and blended afterwards, which lets the compiler
+ * vectorize the loops across plans. Constant segments and masked lanes take the
+ * operations of segment_const_scalar(), ascending and descending ones those of
+ * segment_ascdec_scalar().
+ */
+static void lanes_update(double *restrict p, const double *restrict e, const double *restrict pio,
+                         const double *restrict r, const double *restrict t, const double *restrict asc, double kinv,
+                         int stride)
+{
+    for (int j0 = 0; j0 < stride; j0 += BATCH_LANES) {
+        double *pj = &p[j0];
+        const double *ej = &e[j0];
+        const double *pioj = &pio[j0];
+        const double *rj = &r[j0];
+        const double *tj = &t[j0];
+
+        int ascdec = 0;
+
+        for (int j = 0; j < BATCH_LANES; j++)
+            ascdec |= asc[j0 + j] != 0;
+
+        /* plans at a stop all take the cheaper constant depth update */
+        if (!ascdec) {
+            for (int j = 0; j < BATCH_LANES; j++)
+                pj[j] = pj[j] + (pioj[j] - pj[j]) * (1 - ej[j]);
+
+            continue;
+        }
+
+        double pc[BATCH_LANES];
+        double pa[BATCH_LANES];
+
+        for (int j = 0; j < BATCH_LANES; j++)
+            pc[j] = pj[j] + (pioj[j] - pj[j]) * (1 - ej[j]);
+
+        for (int j = 0; j < BATCH_LANES; j++)
+            pa[j] = pioj[j] + rj[j] * (tj[j] - kinv) - (pioj[j] - pj[j] - (rj[j] * kinv)) * ej[j];
+
+        for (int j = 0; j < BATCH_LANES; j++)
+            pj[j] = asc[j0 + j] ? pa[j] : pc[j];
+    }
+}
+
+static void batch_segment(decostate_batch_t *b)
+{
+    const model_t *m = b->conf->model;
+    const int stride = b->stride;
+
+    propagator_t scratch;
+    const propagator_t *p = NULL;
+
+    int he_loaded = 0;
+
+    /* gather the propagators of every plan in compartment-major order, the padding lanes keep their tissues */
+    for (int j = 0; j < stride; j++) {
+        he_loaded |= b->he_loaded[j] != 0;
+
+        if (b->time[j] == 0) {
+            for (int i = 0; i < 16; i++) {
+                b->e_he[i * stride + j] = 1;
+                b->e_n2[i * stride + j] = 1;
+            }
+
+            continue;
+        }
+
+        /* plans in lockstep mostly share the duration of their segments */
+        if (!p || p->time != b->time[j])
+            p = decoconf_propagator(b->conf, b->time[j], &scratch);
+
+        for (int i = 0; i < 16; i++) {
+            b->e_he[i * stride + j] = p->he_e[i];
+            b->e_n2[i * stride + j] = p->n2_e[i];
+        }
+    }
+
+    /* like the nitrogen only kernels, leave the helium pressures at zero while no plan carries any */
+    for (int i = 0; i < 16 && he_loaded; i++)
+        lanes_update(&b->phe[i * stride], &b->e_he[i * stride], b->pio_he, b->r_he, b->time, b->asc, m->he_kinv[i],
+                     stride);
+
+    for (int i = 0; i < 16; i++)
+        lanes_update(&b->pn2[i * stride], &b->e_n2[i * stride], b->pio_n2, b->r_n2, b->time, b->asc, m->n2_kinv[i],
+                     stride);
+}
+
+void batch_add_segment_ascdec(decostate_batch_t *b, const double *dstart, const double *dend, const double *time,
+                              const gas_t *const *gas)
+{
+    for (int j = 0; j < b->nof_plans; j++) {
+        if (time[j] == 0)
+            lane_mask(b, j);
+        else
+            lane_segment_ascdec(b, j, dstart[j], dend[j], time[j], gas[j]);
+    }
+
+    batch_segment(b);
+}
+
+void batch_add_segment_const(decostate_batch_t *b, const double *depth, const double *time, const gas_t *const *gas)
+{
+    for (int j = 0; j < b->nof_plans; j++) {
+        if (time[j] == 0)
+            lane_mask(b, j);
+        else
+            lane_segment_const(b, j, depth[j], time[j], gas[j]);
+    }
+
+    batch_segment(b);
+}
+
+/*
+ * Same operations as ceiling_scalar(), vectorized across plans. Plans without
+ * helium take those of ceiling_n2_scalar() instead, blocks that mix both
+ * calculate both ceilings and select per plan.
+ */
+void batch_ceiling(const decostate_batch_t *b, const double *gf, double *c)
+{
+    const model_t *m = b->conf->model;
+    const int stride = b->stride;
+
+    for (int j0 = 0; j0 < stride; j0 += BATCH_LANES) {
+        double g[BATCH_LANES];
+        double cb[BATCH_LANES];
+
+        const double *he_loaded = &b->he_loaded[j0];
+
+        int helium = 0;
+
+        for (int j = 0; j < BATCH_LANES; j++) {
+            g[j] = j0 + j < b->nof_plans ? gf[j0 + j] / 100 : 1;
+            cb[j] = 0;
+            helium |= he_loaded[j] != 0;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            const double *phe = &b->phe[i * stride + j0];
+            const double *pn2 = &b->pn2[i * stride + j0];
+
+            double cn[BATCH_LANES];
+
+            for (int j = 0; j < BATCH_LANES; j++)
+                cn[j] = (pn2[j] - (m->n2_a[i] * g[j])) / (g[j] / m->n2_b[i] + 1 - g[j]);
+
+            if (!helium) {
+                for (int j = 0; j < BATCH_LANES; j++)
+                    cb[j] = max(cb[j], cn[j]);
+
+                continue;
+            }
+
+            double cm[BATCH_LANES];
+
+            for (int j = 0; j < BATCH_LANES; j++) {
+                /* scale n2 and he values for a and b proportional to their pressure */
+                double a = ((m->n2_a[i] * pn2[j]) + (m->he_a[i] * phe[j])) / (pn2[j] + phe[j]);
+                double bb = ((m->n2_b[i] * pn2[j]) + (m->he_b[i] * phe[j])) / (pn2[j] + phe[j]);
+
+                cm[j] = ((pn2[j] + phe[j]) - (a * g[j])) / (g[j] / bb + 1 - g[j]);
+            }
+
+            for (int j = 0; j < BATCH_LANES; j++)
+                cb[j] = max(cb[j], he_loaded[j] != 0 ? cm[j] : cn[j]);
+        }
+
+        for (int j = 0; j < BATCH_LANES && j0 + j < b->nof_plans; j++)
+            c[j0 + j] = cb[j];
+    }
+}
+
+static double plan_ceiling(const decostate_batch_t *b, int j, double gf)
+{
+    decostate_t ds;
+    batch_get_plan(b, j, &ds);
+
+    return ceiling(&ds, gf);
+}
+
+static double plan_stop_time(const decostate_batch_t *b, int j, double depth, const gas_t *gas, double gf,
+                             double next_stop)
+{
+    decostate_t ds;
+    batch_get_plan(b, j, &ds);
+
+    return tissues_stop_time(&ds.tissues, b->conf->model, depth, gas, gf, next_stop);
+}
+
+/*
+ * Advance one plan of batch_calc_deco() by a single segment, following the
+ * decisions of calc_deco() and deco_stop(). The ceiling c was calculated with
+ * the current gf of the plan at the start of the step. Returns 0 once the plan
+ * has surfaced.
+ */
+static int lane_step(decostate_batch_t *b, int j, lane_t *l, double c, const gas_schedule_t *deco_gasses,
+                     decoinfo_t *ret)
+{
+    const decoconf_t *conf = b->conf;
+    const opendeco_ctx *ctx = conf->ctx;
+
+    double gf_c = l->current_gf;
+
+    for (;;) {
+        if (l->current_gf != gf_c) {
+            c = plan_ceiling(b, j, l->current_gf);
+            gf_c = l->current_gf;
+        }
+
+        if (l->state == LANE_ASCENT) {
+            if (c < l->next_stop && !surfaced(ctx, l->depth)) {
+                /* switch to better gas if available */
+                const gas_t *best = gas_schedule_best(deco_gasses, l->depth);
+
+                if (opendeco_ctx_switch_intermediate(ctx) && best && best != l->gas) {
+                    l->gas = best;
+
+                    lane_segment_const(b, j, l->depth, 1, l->gas);
+                    ret->tts += 1;
+
+                    return 1;
+                }
+
+                /* ascend to next stop */
+                double time = decoconf_ascent_time(conf, l->depth, l->next_stop);
+
+                lane_segment_ascdec(b, j, l->depth, l->next_stop, time, l->gas);
+                ret->tts += time;
+
+                l->depth = l->next_stop;
+
+                /* make next stop shallower */
+                l->next_stop -= conf->ceil_multiple;
+
+                if (opendeco_ctx_last_stop_at_six(ctx) && l->next_stop < abs_depth(ctx, msw_to_bar(6)))
+                    l->next_stop = opendeco_ctx_surface_pressure(ctx);
+
+                /* recalculate gf */
+                l->current_gf = decoconf_gf(conf, b->firststop[j], l->next_stop);
+
+                return 1;
+            }
+
+            if (b->firststop[j] == -1) {
+                b->firststop[j] = l->depth;
+
+                /* the new gf may allow us to ascend further */
+                l->current_gf = decoconf_gf(conf, b->firststop[j], l->next_stop);
+                continue;
+            }
+
+            /* terminate if we surfaced */
+            if (surfaced(ctx, l->depth))
+                return 0;
+
+            /* switch to better gas if available */
+            const gas_t *best = gas_schedule_best(deco_gasses, l->depth);
+
+            if (best)
+                l->gas = best;
+
+            l->state = LANE_STOP;
+        }
+
+        /* take the solved stop time first, as deco_stop() does */
+        if (l->state == LANE_STOP) {
+            double stoplen = plan_stop_time(b, j, l->depth, l->gas, l->current_gf, l->next_stop);
+
+            l->state = LANE_STEP;
+
+            /* the stop never clears, like calc_deco() the plan ends here */
+            if (isinf(stoplen)) {
+                ret->tts = INFINITY;
+                return 0;
+            }
+
+            if (stoplen) {
+                lane_segment_const(b, j, l->depth, stoplen, l->gas);
+                ret->tts += stoplen;
+
+                return 1;
+            }
+        }
+
+        /* step on until ceiling rises above next stop */
+        if (c > l->next_stop) {
+            lane_segment_const(b, j, l->depth, 1, l->gas);
+            ret->tts += 1;
+
+            return 1;
+        }
+
+        l->state = LANE_ASCENT;
+    }
+}
+
+/*
+ * Run calc_deco() for every plan of the batch in lockstep. Every step applies
+ * one segment to all plans that are still decompressing, plans that surfaced
+ * or that only need their ndl are masked out. All plans share the deco gasses.
+ * Returns -1 if the bookkeeping could not be allocated.
+ */
+int batch_calc_deco(decostate_batch_t *b, const double *start_depth, const gas_t *const *start_gas,
+                    const gas_t *deco_gasses, int nof_gasses, decoinfo_t *ret)
+{
+    const decoconf_t *conf = b->conf;
+    const opendeco_ctx *ctx = conf->ctx;
+    const double asc_per_min = msw_to_bar(9);
+
+    lane_t *lanes = malloc(b->nof_plans * sizeof(lane_t));
+    double *gf = malloc(b->nof_plans * sizeof(double));
+    double *c = malloc(b->nof_plans * sizeof(double));
+
+    if (!lanes || !gf || !c) {
+        free(lanes);
+        free(gf);
+        free(c);
+        return -1;
+    }
+
+    gas_schedule_t schedule;
+    init_gas_schedule(&schedule, conf, deco_gasses, nof_gasses);
+
+    int active = 0;
+
+    /* setup start parameters */
+    for (int j = 0; j < b->nof_plans; j++) {
+        lane_t *l = &lanes[j];
+
+        l->depth = start_depth[j];
+        l->gas = start_gas[j];
+
+        ret[j] = (decoinfo_t){.tts = 0, .ndl = 0};
+
+        /* check if direct ascent is possible */
+        decostate_t ds;
+        batch_get_plan(b, j, &ds);
+
+        if (direct_ascent(&ds, l->depth, gauge_depth(ctx, l->depth) / asc_per_min, l->gas)) {
+            ret[j].ndl = calc_ndl(&ds, l->depth, asc_per_min, l->gas);
+            l->state = LANE_DONE;
+            continue;
+        }
+
+        const double cm = conf->ceil_multiple;
+
+        l->next_stop = abs_depth(ctx, cm * (ceil(gauge_depth(ctx, l->depth) / cm) - 1));
+
+        if (l->next_stop == l->depth)
+            l->next_stop -= cm;
+
+        l->current_gf = decoconf_gf(conf, b->firststop[j], l->next_stop);
+        l->state = LANE_ASCENT;
+
+        active++;
+    }
+
+    while (active) {
+        for (int j = 0; j < b->nof_plans; j++)
+            gf[j] = lanes[j].state == LANE_DONE ? conf->gfhi : lanes[j].current_gf;
+
+        batch_ceiling(b, gf, c);
+
+        for (int j = 0; j < b->nof_plans; j++) {
+            lane_mask(b, j);
+
+            if (lanes[j].state == LANE_DONE)
+                continue;
+
+            if (!lane_step(b, j, &lanes[j], c[j], &schedule, &ret[j])) {
+                lanes[j].state = LANE_DONE;
+                active--;
+            }
+        }
+
+        batch_segment(b);
+    }
+
+    free(lanes);
+    free(gf);
+    free(c);
+
+    return 0;
+}
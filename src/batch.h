@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "deco.h"
+#include "schedule.h"
+
+#define BATCH_LANES 8
+
+/* types */
+typedef struct decostate_batch_t {
+    const decoconf_t *conf;
+    int nof_plans;
+    int stride; /* nof_plans rounded up to a multiple of BATCH_LANES */
+
+    /* tissue pressures, compartment i of plan j is stored at [i * stride + j] */
+    double *phe;
+    double *pn2;
+
+    double *firststop;
+    double *max_depth;
+    double *he_loaded; /* non-zero once the plan has breathed helium */
+
+    /* per plan segment parameters, a plan with time 0 is masked out */
+    double *e_he;
+    double *e_n2;
+    double *pio_he;
+    double *pio_n2;
+    double *r_he;
+    double *r_n2;
+    double *time;
+    double *asc;
+
+    void *mem;
+} decostate_batch_t;
+
+/* functions */
+int init_decostate_batch(decostate_batch_t *b, const decoconf_t *conf, int nof_plans);
+void free_decostate_batch(decostate_batch_t *b);
+
+void batch_set_plan(decostate_batch_t *b, int plan, const decostate_t *ds);
+void batch_get_plan(const decostate_batch_t *b, int plan, decostate_t *ds);
+
+void batch_add_segment_ascdec(decostate_batch_t *b, const double *dstart, const double *dend, const double *time,
+                              const gas_t *const *gas);
+void batch_add_segment_const(decostate_batch_t *b, const double *depth, const double *time, const gas_t *const *gas);
+void batch_ceiling(const decostate_batch_t *b, const double *gf, double *c);
+
+int batch_calc_deco(decostate_batch_t *b, const double *start_depth, const gas_t *const *start_gas,
+                    const gas_t *deco_gasses, int nof_gasses, decoinfo_t *ret);
+
+#endif /* end of include guard: BATCH_H */
@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "contingency.h"
+
+#define CONTINGENCY_GF_VARIANTS 2
+
+/* the tissues after a descent at 9m/min and a stay at depth until time, as in the dive plan */
+static void bottom_phase(decostate_t *ds, double depth, double time, const gas_t *gas)
+{
+    const double descent_time = gauge_depth(ds->conf->ctx, depth) / msw_to_bar(9);
+
+    const waypoint_t waypoints[] = {
+        {.depth = depth, .time = descent_time,                 .gas = gas},
+        {.depth = depth, .time = max(1, time - descent_time), .gas = gas},
+    };
+
+    simulate_dive(ds, waypoints, len(waypoints), NULL);
+}
+
+static void plan_variant(void *arg, int i)
+{
+    contingency_t *v = &((contingency_t *) arg)[i];
+
+    gas_schedule_t schedule;
+    init_gas_schedule(&schedule, &v->conf, v->deco_gasses, v->nof_gasses);
+
+    calc_deco_plan(&v->plan, &v->ds, v->depth, v->gas, &schedule);
+}
+
+static contingency_t *add_variant(contingency_slate_t *slate, enum CONTINGENCY type, const decoconf_t *conf,
+                                  const decostate_t *ds, double depth, const gas_t *gas, const gas_t *deco_gasses,
+                                  int nof_gasses)
+{
+    contingency_t *v = &slate->variants[slate->nof_variants++];
+
+    v->conf = *conf;
+    v->ds = *ds;
+    v->ds.conf = &v->conf;
+
+    v->type = type;
+    v->depth = depth;
+    v->gas = gas;
+    v->lost_gas = NULL;
+    v->deco_gasses = deco_gasses;
+    v->nof_gasses = nof_gasses;
+
+    return v;
+}
+
+/*
+ * Plan the dive to depth for time minutes together with its contingencies: a
+ * deeper dive, a longer dive, both, the loss of each deco gas and higher gf
+ * high values. The variants share the tissues of the bottom phases they have
+ * in common, and their deco schedules are calculated concurrently on the pool.
+ * The variants use deco_gasses in place, so they must outlive the slate, only
+ * the lost gas variants get a list of their own. Returns -1 if memory cannot
+ * be allocated.
+ */
+int contingency_slate(contingency_slate_t *slate, const decoconf_t *conf, double depth, double time,
+                      const gas_t *bottom_gas, const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    const int max_variants = 4 + nof_gasses + CONTINGENCY_GF_VARIANTS;
+
+    slate->nof_variants = 0;
+    slate->lost_gasses = malloc(max(1, nof_gasses * (nof_gasses - 1)) * sizeof(gas_t));
+
+    if (!slate->lost_gasses || posix_memalign((void **) &slate->variants, 64, max_variants * sizeof(contingency_t))) {
+        free(slate->lost_gasses);
+        slate->lost_gasses = NULL;
+        return -1;
+    }
+
+    /* the bottom phases, longer dives extend the shorter ones */
+    const double deeper = depth + msw_to_bar(CONTINGENCY_DEEPER);
+
+    decostate_t ds[4];
+
+    for (int i = 0; i < 4; i++)
+        init_decostate(&ds[i], conf);
+
+    bottom_phase(&ds[0], depth, time, bottom_gas);
+    bottom_phase(&ds[2], deeper, time, bottom_gas);
+
+    ds[1] = ds[0];
+    ds[3] = ds[2];
+
+    add_segment_const(&ds[1], depth, CONTINGENCY_LONGER, bottom_gas);
+    add_segment_const(&ds[3], deeper, CONTINGENCY_LONGER, bottom_gas);
+
+    add_variant(slate, CONTINGENCY_PLAN, conf, &ds[0], depth, bottom_gas, deco_gasses, nof_gasses);
+    add_variant(slate, CONTINGENCY_DEEPER_DIVE, conf, &ds[2], deeper, bottom_gas, deco_gasses, nof_gasses);
+    add_variant(slate, CONTINGENCY_LONGER_DIVE, conf, &ds[1], depth, bottom_gas, deco_gasses, nof_gasses);
+    add_variant(slate, CONTINGENCY_DEEPER_LONGER_DIVE, conf, &ds[3], deeper, bottom_gas, deco_gasses, nof_gasses);
+
+    /* every deco gas lost in turn, the remaining ones keep their order */
+    for (int i = 0; i < nof_gasses; i++) {
+        gas_t *left = &slate->lost_gasses[i * (nof_gasses - 1)];
+
+        for (int j = 0; j < nof_gasses - 1; j++)
+            left[j] = deco_gasses[j < i ? j : j + 1];
+
+        contingency_t *v =
+            add_variant(slate, CONTINGENCY_LOST_GAS, conf, &ds[0], depth, bottom_gas, left, nof_gasses - 1);
+
+        v->lost_gas = &deco_gasses[i];
+    }
+
+    for (int i = 1; i <= CONTINGENCY_GF_VARIANTS && conf->gfhi + (i - 1) * CONTINGENCY_GF_STEP < 100; i++) {
+        contingency_t *v =
+            add_variant(slate, CONTINGENCY_HIGHER_GF, conf, &ds[0], depth, bottom_gas, deco_gasses, nof_gasses);
+
+        v->conf.gfhi = min(100, conf->gfhi + i * CONTINGENCY_GF_STEP);
+    }
+
+    pool_for(pool, slate->nof_variants, &plan_variant, slate->variants);
+
+    return 0;
+}
+
+void free_contingency_slate(contingency_slate_t *slate)
+{
+    free(slate->variants);
+    free(slate->lost_gasses);
+    slate->variants = NULL;
+    slate->lost_gasses = NULL;
+    slate->nof_variants = 0;
+}
+
+static void plan_bailout(void *arg, int i)
+{
+    bailout_matrix_t *matrix = arg;
+    bailout_t *b = &matrix->bailouts[i];
+
+    calc_deco_plan(&b->plan, &b->ds, matrix->depth, matrix->gas, &matrix->schedule);
+}
+
+/*
+ * Plan the ascent for bailing out at every whole minute of runtime up to time
+ * on a dive to depth. A single decostate is advanced along the bottom phase a
+ * minute at a time and the tissues at every minute are checkpointed, so the
+ * bottom phase is only simulated once. The ascents from all checkpoints are
+ * then planned concurrently on the pool. The first bailout is at the first
+ * whole minute after a minute at depth, or at time for shorter dives. Returns
+ * -1 if memory cannot be allocated.
+ */
+int bailout_matrix(bailout_matrix_t *matrix, const decoconf_t *conf, double depth, double time,
+                   const gas_t *bottom_gas, const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    const double descent_time = gauge_depth(conf->ctx, depth) / msw_to_bar(9);
+    const int last = max(1, floor(time));
+    const int first = min(last, ceil(descent_time + 1));
+
+    matrix->depth = depth;
+    matrix->gas = bottom_gas;
+    matrix->nof_bailouts = last - first + 1;
+
+    init_gas_schedule(&matrix->schedule, conf, deco_gasses, nof_gasses);
+
+    if (posix_memalign((void **) &matrix->bailouts, 64, matrix->nof_bailouts * sizeof(bailout_t)))
+        return -1;
+
+    decostate_t ds;
+    init_decostate(&ds, conf);
+    bottom_phase(&ds, depth, first, bottom_gas);
+
+    for (int i = 0; i < matrix->nof_bailouts; i++) {
+        if (i)
+            add_segment_const(&ds, depth, 1, bottom_gas);
+
+        matrix->bailouts[i].time = first + i;
+        matrix->bailouts[i].ds = ds;
+    }
+
+    pool_for(pool, matrix->nof_bailouts, &plan_bailout, matrix);
+
+    return 0;
+}
+
+void free_bailout_matrix(bailout_matrix_t *matrix)
+{
+    free(matrix->bailouts);
+    matrix->bailouts = NULL;
+    matrix->nof_bailouts = 0;
+}
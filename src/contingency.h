@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef CONTINGENCY_H
+#define CONTINGENCY_H
+
+#include "deco.h"
+#include "pool.h"
+#include "schedule.h"
+
+#define CONTINGENCY_DEEPER 3  /* meters */
+#define CONTINGENCY_LONGER 5  /* minutes */
+#define CONTINGENCY_GF_STEP 10
+
+/* types */
+enum CONTINGENCY {
+    CONTINGENCY_PLAN,
+    CONTINGENCY_DEEPER_DIVE,
+    CONTINGENCY_LONGER_DIVE,
+    CONTINGENCY_DEEPER_LONGER_DIVE,
+    CONTINGENCY_LOST_GAS,
+    CONTINGENCY_HIGHER_GF,
+};
+
+typedef struct contingency_t {
+    decostate_t ds; /* the tissues at the end of the bottom phase, surfaced once planned */
+    decoconf_t conf;
+
+    enum CONTINGENCY type;
+    double depth;
+    const gas_t *gas;
+    const gas_t *lost_gas; /* for CONTINGENCY_LOST_GAS */
+
+    const gas_t *deco_gasses; /* those of the slate, or a copy without the lost gas */
+    int nof_gasses;
+
+    decoplan_t plan;
+} contingency_t;
+
+typedef struct contingency_slate_t {
+    int nof_variants;
+    contingency_t *variants;
+    gas_t *lost_gasses; /* the deco gasses left for every lost gas variant */
+} contingency_slate_t;
+
+typedef struct bailout_t {
+    int time;       /* runtime at the start of the ascent in minutes */
+    decostate_t ds; /* the tissues at that time, surfaced once planned */
+    decoplan_t plan;
+} bailout_t;
+
+typedef struct bailout_matrix_t {
+    double depth;
+    const gas_t *gas;
+    gas_schedule_t schedule;
+
+    int nof_bailouts;
+    bailout_t *bailouts;
+} bailout_matrix_t;
+
+/* functions */
+int contingency_slate(contingency_slate_t *slate, const decoconf_t *conf, double depth, double time,
+                      const gas_t *bottom_gas, const gas_t *deco_gasses, int nof_gasses, pool_t *pool);
+void free_contingency_slate(contingency_slate_t *slate);
+
+int bailout_matrix(bailout_matrix_t *matrix, const decoconf_t *conf, double depth, double time,
+                   const gas_t *bottom_gas, const gas_t *deco_gasses, int nof_gasses, pool_t *pool);
+void free_bailout_matrix(bailout_matrix_t *matrix);
+
+#endif /* end of include guard: CONTINGENCY_H */
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "decimate.h"
+
+typedef struct span_t {
+    int first;
+    int last;
+} span_t;
+
+/* the depth the merged segment from waypoint a to b is at when waypoint i is reached */
+static double interpolate(const double *runtime, const waypoint_t *wp, int a, int b, int i)
+{
+    return wp[a].depth + (wp[b].depth - wp[a].depth) * (runtime[i] - runtime[a]) / (runtime[b] - runtime[a]);
+}
+
+/* the inert fraction of gas, which scales a depth error into a compartment pressure error */
+static double inert_fraction(const gas_t *gas)
+{
+    return max(0.01, (gas_n2(gas) + gas_he(gas)) / 100.0);
+}
+
+/*
+ * Douglas-Peucker on depth against runtime between waypoints first and last,
+ * which are both kept and breathe the same gas in between. A waypoint is kept
+ * if any waypoint between its neighbours would be more than max_error from the
+ * merged segment, measured as the depth error at the same runtime.
+ */
+static void decimate_run(char *keep, span_t *stack, const double *runtime, const waypoint_t *wp, int first,
+                         int last, double max_error)
+{
+    int top = 0;
+    stack[top++] = (span_t){first, last};
+
+    while (top) {
+        span_t s = stack[--top];
+
+        double err_max = -1;
+        int worst = -1;
+
+        for (int i = s.first + 1; i < s.last; i++) {
+            double err = fabs(wp[i].depth - interpolate(runtime, wp, s.first, s.last, i));
+
+            if (err > err_max) {
+                err_max = err;
+                worst = i;
+            }
+        }
+
+        if (err_max > max_error) {
+            keep[worst] = 1;
+            stack[top++] = (span_t){s.first, worst};
+            stack[top++] = (span_t){worst, s.last};
+        }
+    }
+}
+
+/*
+ * Merge consecutive waypoints of a dive that starts at start_depth into fewer,
+ * longer segments. Tissue pressures follow the inspired pressure as a low-pass
+ * filter, so they never deviate more than the inspired pressure of the merged
+ * profile does. The depth error of every gas is therefore bounded by tolerance
+ * over its inert fraction, which bounds every compartment pressure error by
+ * tolerance bar. Gas switches and instantaneous depth changes are kept.
+ *
+ * Writes the waypoints to out, which may be waypoints itself, and returns how
+ * many there are, or -1 if memory cannot be allocated.
+ */
+int decimate_dive(waypoint_t *out, const waypoint_t *waypoints, int nof_waypoints, double start_depth,
+                  double tolerance)
+{
+    if (nof_waypoints <= 0)
+        return 0;
+
+    /* index 0 is the start of the dive, waypoint i is at index i + 1 */
+    const int n = nof_waypoints + 1;
+
+    waypoint_t *wp = malloc(n * sizeof(waypoint_t));
+    double *runtime = malloc(n * sizeof(double));
+    char *keep = calloc(n, sizeof(char));
+    span_t *stack = malloc(n * sizeof(span_t));
+
+    if (!wp || !runtime || !keep || !stack) {
+        free(wp);
+        free(runtime);
+        free(keep);
+        free(stack);
+        return -1;
+    }
+
+    wp[0] = (waypoint_t){.depth = start_depth, .time = 0, .gas = waypoints[0].gas};
+    runtime[0] = 0;
+
+    for (int i = 1; i < n; i++) {
+        wp[i] = waypoints[i - 1];
+        runtime[i] = runtime[i - 1] + wp[i].time;
+    }
+
+    /* the segment reaching waypoint i is breathed on its gas, merged segments must share it */
+    keep[0] = 1;
+    keep[n - 1] = 1;
+
+    for (int i = 1; i < n - 1; i++)
+        if (!gas_equal(wp[i].gas, wp[i + 1].gas) || wp[i + 1].time <= 0)
+            keep[i] = 1;
+
+    for (int i = 1; i < n; i++)
+        if (wp[i].time <= 0)
+            keep[i] = 1;
+
+    for (int first = 0, last = 1; last < n; last++) {
+        if (!keep[last])
+            continue;
+
+        decimate_run(keep, stack, runtime, wp, first, last, tolerance / inert_fraction(wp[last].gas));
+        first = last;
+    }
+
+    /* the merged segments last from one kept waypoint to the next */
+    int nof_out = 0;
+    int prev = 0;
+
+    for (int i = 1; i < n; i++) {
+        if (!keep[i])
+            continue;
+
+        out[nof_out++] = (waypoint_t){
+            .depth = wp[i].depth,
+            .time = runtime[i] - runtime[prev],
+            .gas = wp[i].gas,
+        };
+
+        prev = i;
+    }
+
+    free(wp);
+    free(runtime);
+    free(keep);
+    free(stack);
+
+    return nof_out;
+}
@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include "deco.h"
+#include "schedule.h"
+
+/* functions */
+int decimate_dive(waypoint_t *out, const waypoint_t *waypoints, int nof_waypoints, double start_depth,
+                  double tolerance);
+
+#endif /* end of include guard: DECIMATE_H */
@@ -2,20 +2,44 @@
 
 #include <assert.h>
 #include <math.h>
-#include <stdbool.h>
+#include <pthread.h>
+#include <stdlib.h>
 
 #include "deco.h"
+#include "kernel.h"
 
 #define RND(x) (round((x) *10000) / 10000)
 
-enum ALGO ALGO_VER = ALGO_VER_DEFAULT;
+/* gradient factors evaluated per pass over the compartments */
+#define CEILINGS_CHUNK 32
+
+#define PROPAGATOR_TOLERANCE 1E-9
+
 double SURFACE_PRESSURE = SURFACE_PRESSURE_DEFAULT;
-double P_WV = P_WV_DEFAULT;
 
 double PO2_MAX = PO2_MAX_DEFAULT;
 double END_MAX = END_MAX_DEFAULT;
 
 int LAST_STOP_AT_SIX = LAST_STOP_AT_SIX_DEFAULT;
+int SWITCH_INTERMEDIATE = SWITCH_INTERMEDIATE_DEFAULT;
+
+/*
+ * Settings and model of a planner. A NULL context is the default context,
+ * which reads the global variables above and, like them, is not reentrant.
+ * Its model is always ALGO_VER_DEFAULT with P_WV_DEFAULT, built once on first
+ * use, other models need a context from opendeco_ctx_new(). So do plans that
+ * are spread over a pool_t.
+ */
+struct opendeco_ctx {
+    model_t model;
+
+    double surface_pressure;
+    double po2_max;
+    double end_max;
+
+    int last_stop_at_six;
+    int switch_intermediate;
+};
 
 typedef struct zhl_n2_t {
     double t;
@@ -77,23 +101,116 @@ double msw_to_bar(double msw)
     return msw / 10;
 }
 
-double abs_depth(double gd)
+opendeco_ctx *opendeco_ctx_new(enum ALGO algo, double p_wv)
+{
+    opendeco_ctx *ctx;
+
+    /* the model is cache line aligned */
+    if (posix_memalign((void **) &ctx, 64, sizeof(opendeco_ctx)))
+        return NULL;
+
+    model_init(&ctx->model, algo, p_wv);
+
+    ctx->surface_pressure = SURFACE_PRESSURE_DEFAULT;
+    ctx->po2_max = PO2_MAX_DEFAULT;
+    ctx->end_max = END_MAX_DEFAULT;
+    ctx->last_stop_at_six = LAST_STOP_AT_SIX_DEFAULT;
+    ctx->switch_intermediate = SWITCH_INTERMEDIATE_DEFAULT;
+
+    return ctx;
+}
+
+void opendeco_ctx_free(opendeco_ctx *ctx)
+{
+    free(ctx);
+}
+
+void opendeco_ctx_set_surface_pressure(opendeco_ctx *ctx, double surface_pressure)
+{
+    ctx->surface_pressure = surface_pressure;
+}
+
+void opendeco_ctx_set_po2_max(opendeco_ctx *ctx, double po2_max)
+{
+    ctx->po2_max = po2_max;
+}
+
+void opendeco_ctx_set_end_max(opendeco_ctx *ctx, double end_max)
+{
+    ctx->end_max = end_max;
+}
+
+void opendeco_ctx_set_last_stop_at_six(opendeco_ctx *ctx, int last_stop_at_six)
+{
+    ctx->last_stop_at_six = last_stop_at_six;
+}
+
+void opendeco_ctx_set_switch_intermediate(opendeco_ctx *ctx, int switch_intermediate)
+{
+    ctx->switch_intermediate = switch_intermediate;
+}
+
+static model_t default_model;
+static pthread_once_t default_model_once = PTHREAD_ONCE_INIT;
+
+static void init_default_model(void)
+{
+    model_init(&default_model, ALGO_VER_DEFAULT, P_WV_DEFAULT);
+}
+
+const model_t *opendeco_ctx_model(const opendeco_ctx *ctx)
+{
+    if (ctx)
+        return &ctx->model;
+
+    /* never rebuilt, plans on other threads may be using it */
+    pthread_once(&default_model_once, &init_default_model);
+
+    return &default_model;
+}
+
+double opendeco_ctx_surface_pressure(const opendeco_ctx *ctx)
+{
+    return ctx ? ctx->surface_pressure : SURFACE_PRESSURE;
+}
+
+double opendeco_ctx_po2_max(const opendeco_ctx *ctx)
+{
+    return ctx ? ctx->po2_max : PO2_MAX;
+}
+
+double opendeco_ctx_end_max(const opendeco_ctx *ctx)
+{
+    return ctx ? ctx->end_max : END_MAX;
+}
+
+int opendeco_ctx_last_stop_at_six(const opendeco_ctx *ctx)
 {
-    return gd + SURFACE_PRESSURE;
+    return ctx ? ctx->last_stop_at_six : LAST_STOP_AT_SIX;
 }
 
-double gauge_depth(double ad)
+int opendeco_ctx_switch_intermediate(const opendeco_ctx *ctx)
 {
-    return ad - SURFACE_PRESSURE;
+    return ctx ? ctx->switch_intermediate : SWITCH_INTERMEDIATE;
 }
 
-gas_t gas_new(unsigned char o2, unsigned char he, double mod)
+double abs_depth(const opendeco_ctx *ctx, double gd)
+{
+    return gd + opendeco_ctx_surface_pressure(ctx);
+}
+
+double gauge_depth(const opendeco_ctx *ctx, double ad)
+{
+    return ad - opendeco_ctx_surface_pressure(ctx);
+}
+
+gas_t gas_new(const opendeco_ctx *ctx, unsigned char o2, unsigned char he, double mod)
 {
     assert(o2 + he <= 100);
 
     if (mod == MOD_AUTO) {
-        double mod_po2 = PO2_MAX / (o2 / 100.0);
-        double mod_end = END_MAX / (1 - he / 100.0);
+        double mod_po2 = opendeco_ctx_po2_max(ctx) / (o2 / 100.0);
+        double mod_end = opendeco_ctx_end_max(ctx) / (1 - he / 100.0);
 
         mod = min(mod_po2, mod_end);
     }
@@ -126,32 +243,220 @@ double gas_mod(const gas_t *gas)
     return gas->mod;
 }
 
-double add_segment_ascdec(decostate_t *ds, double dstart, double dend, double time, const gas_t *gas)
+void model_init(model_t *model, enum ALGO algo, double p_wv)
+{
+    for (int i = 0; i < 16; i++) {
+        model->he_k[i] = log(2) / ZHL16He[i].t;
+        model->he_kinv[i] = 1 / model->he_k[i];
+        model->he_a[i] = ZHL16He[i].a;
+        model->he_b[i] = ZHL16He[i].b;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        model->n2_k[i] = log(2) / ZHL16N[i].t;
+        model->n2_kinv[i] = 1 / model->n2_k[i];
+        model->n2_a[i] = ZHL16N[i].a[algo];
+        model->n2_b[i] = ZHL16N[i].b;
+    }
+
+    model->algo = algo;
+    model->p_wv = p_wv;
+
+    kernel_init();
+
+    for (int i = 0; i < MODEL_MINUTES; i++)
+        kernel_propagate(&model->minutes[i], model, i + 1);
+}
+
+/* whether p was computed for time, up to the rounding of the depths time was derived from, by the active kernel */
+static int propagator_serves(const propagator_t *p, double time)
+{
+    return fabs(p->time - time) < PROPAGATOR_TOLERANCE && p->kernel == kernel_active();
+}
+
+/*
+ * Return the propagator for a segment of the given duration, the one the model
+ * keeps if it has one for this duration and the active kernel, otherwise it is
+ * computed into scratch. A model is not written after model_init(), so it can
+ * be shared between threads.
+ */
+const propagator_t *model_propagator(const model_t *model, double time, propagator_t *scratch)
+{
+    const double minutes = round(time);
+
+    if (minutes >= 1 && minutes <= MODEL_MINUTES && propagator_serves(&model->minutes[(int) minutes - 1], time))
+        return &model->minutes[(int) minutes - 1];
+
+    kernel_propagate(scratch, model, time);
+
+    return scratch;
+}
+
+static void segment_ascdec(tissues_t *t, const model_t *m, const propagator_t *p, double dstart, double dend,
+                           double time, const gas_t *gas)
+{
+    const double rate = (dend - dstart) / time;
+
+    const double pio_he = gas_he(gas) / 100.0 * (dstart - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (dstart - m->p_wv);
+    const double r_he = gas_he(gas) / 100.0 * rate;
+    const double r_n2 = gas_n2(gas) / 100.0 * rate;
+
+    kernel_segment_ascdec(t, m, p, pio_he, pio_n2, r_he, r_n2, time);
+}
+
+static void segment_const(tissues_t *t, const model_t *m, const propagator_t *p, double depth, const gas_t *gas)
+{
+    const double pio_he = gas_he(gas) / 100.0 * (depth - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (depth - m->p_wv);
+
+    kernel_segment_const(t, p, pio_he, pio_n2);
+}
+
+void tissues_add_segment_ascdec(tissues_t *t, const model_t *m, double dstart, double dend, double time,
+                                const gas_t *gas)
+{
+    assert(time > 0);
+
+    propagator_t scratch;
+    segment_ascdec(t, m, model_propagator(m, time, &scratch), dstart, dend, time, gas);
+}
+
+void tissues_add_segment_const(tissues_t *t, const model_t *m, double depth, double time, const gas_t *gas)
+{
+    assert(time > 0);
+
+    propagator_t scratch;
+    segment_const(t, m, model_propagator(m, time, &scratch), depth, gas);
+}
+
+double tissues_ceiling(const tissues_t *t, const model_t *m, double gf)
+{
+    return kernel_ceiling(t, m, gf / 100);
+}
+
+/* tissues_ceiling() at n gradient factors, bit-identical to n separate calls */
+void tissues_ceilings(const tissues_t *t, const model_t *m, const double *gf, int n, double *c)
+{
+    double f[CEILINGS_CHUNK];
+
+    for (int j = 0; j < n; j += CEILINGS_CHUNK) {
+        const int k = min(n - j, CEILINGS_CHUNK);
+
+        for (int i = 0; i < k; i++)
+            f[i] = gf[j + i] / 100;
+
+        kernel_ceilings(t, m, f, k, &c[j]);
+    }
+}
+
+void segment_op_identity(segment_op_t *op)
+{
+    for (int i = 0; i < 16; i++) {
+        op->he_mul[i] = 1;
+        op->he_add[i] = 0;
+        op->n2_mul[i] = 1;
+        op->n2_add[i] = 0;
+    }
+
+    op->max_depth = 0;
+    op->he_loaded = 0;
+}
+
+/*
+ * Both segment updates are affine in the tissue pressure: the pressure decays
+ * by exp(-k * time) towards a term that only depends on the segment.
+ */
+void segment_op_ascdec(segment_op_t *op, const model_t *m, double dstart, double dend, double time, const gas_t *gas)
 {
     assert(time > 0);
 
     const double rate = (dend - dstart) / time;
 
+    const double pio_he = gas_he(gas) / 100.0 * (dstart - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (dstart - m->p_wv);
+    const double r_he = gas_he(gas) / 100.0 * rate;
+    const double r_n2 = gas_n2(gas) / 100.0 * rate;
+
+    propagator_t scratch;
+    const propagator_t *p = model_propagator(m, time, &scratch);
+
     for (int i = 0; i < 16; i++) {
-        double pio = gas_he(gas) / 100.0 * (dstart - P_WV);
-        double po = ds->phe[i];
-        double r = gas_he(gas) / 100.0 * rate;
-        double k = log(2) / ZHL16He[i].t;
-        double t = time;
+        op->he_mul[i] = p->he_e[i];
+        op->he_add[i] = pio_he + r_he * (time - m->he_kinv[i]) - (pio_he - (r_he * m->he_kinv[i])) * p->he_e[i];
+        op->n2_mul[i] = p->n2_e[i];
+        op->n2_add[i] = pio_n2 + r_n2 * (time - m->n2_kinv[i]) - (pio_n2 - (r_n2 * m->n2_kinv[i])) * p->n2_e[i];
+    }
+
+    op->max_depth = dend;
+    op->he_loaded = gas_he(gas) != 0;
+}
 
-        ds->phe[i] = pio + r * (t - 1 / k) - (pio - po - (r / k)) * exp(-k * t);
+void segment_op_const(segment_op_t *op, const model_t *m, double depth, double time, const gas_t *gas)
+{
+    assert(time > 0);
+
+    const double pio_he = gas_he(gas) / 100.0 * (depth - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (depth - m->p_wv);
+
+    propagator_t scratch;
+    const propagator_t *p = model_propagator(m, time, &scratch);
+
+    for (int i = 0; i < 16; i++) {
+        op->he_mul[i] = p->he_e[i];
+        op->he_add[i] = pio_he * (1 - p->he_e[i]);
+        op->n2_mul[i] = p->n2_e[i];
+        op->n2_add[i] = pio_n2 * (1 - p->n2_e[i]);
     }
 
+    op->max_depth = depth;
+    op->he_loaded = gas_he(gas) != 0;
+}
+
+/* op becomes the operator of first followed by second, op may alias either */
+void segment_op_compose(segment_op_t *op, const segment_op_t *first, const segment_op_t *second)
+{
     for (int i = 0; i < 16; i++) {
-        double pio = gas_n2(gas) / 100.0 * (dstart - P_WV);
-        double po = ds->pn2[i];
-        double r = gas_n2(gas) / 100.0 * rate;
-        double k = log(2) / ZHL16N[i].t;
-        double t = time;
+        double he_add = second->he_mul[i] * first->he_add[i] + second->he_add[i];
+        double n2_add = second->n2_mul[i] * first->n2_add[i] + second->n2_add[i];
 
-        ds->pn2[i] = pio + r * (t - 1 / k) - (pio - po - (r / k)) * exp(-k * t);
+        op->he_mul[i] = second->he_mul[i] * first->he_mul[i];
+        op->he_add[i] = he_add;
+        op->n2_mul[i] = second->n2_mul[i] * first->n2_mul[i];
+        op->n2_add[i] = n2_add;
     }
 
+    op->max_depth = max(first->max_depth, second->max_depth);
+    op->he_loaded = first->he_loaded || second->he_loaded;
+}
+
+void tissues_apply_segment_op(tissues_t *restrict t, const segment_op_t *restrict op)
+{
+    for (int i = 0; i < 16; i++)
+        t->phe[i] = op->he_mul[i] * t->phe[i] + op->he_add[i];
+
+    for (int i = 0; i < 16; i++)
+        t->pn2[i] = op->n2_mul[i] * t->pn2[i] + op->n2_add[i];
+
+    t->he_loaded |= op->he_loaded;
+}
+
+void apply_segment_op(decostate_t *ds, const segment_op_t *op)
+{
+    tissues_apply_segment_op(&ds->tissues, op);
+
+    if (op->max_depth > ds->max_depth)
+        ds->max_depth = op->max_depth;
+}
+
+double add_segment_ascdec(decostate_t *ds, double dstart, double dend, double time, const gas_t *gas)
+{
+    assert(time > 0);
+
+    propagator_t scratch;
+    segment_ascdec(&ds->tissues, ds->conf->model, decoconf_propagator(ds->conf, time, &scratch), dstart, dend, time,
+                   gas);
+
     /* TODO add CNS */
     /* TODO add OTU */
 
@@ -165,23 +470,8 @@ double add_segment_const(decostate_t *ds, double depth, double time, const gas_t
 {
     assert(time > 0);
 
-    for (int i = 0; i < 16; i++) {
-        double pio = gas_he(gas) / 100.0 * (depth - P_WV);
-        double po = ds->phe[i];
-        double k = log(2) / ZHL16He[i].t;
-        double t = time;
-
-        ds->phe[i] = po + (pio - po) * (1 - exp(-k * t));
-    }
-
-    for (int i = 0; i < 16; i++) {
-        double pio = gas_n2(gas) / 100.0 * (depth - P_WV);
-        double po = ds->pn2[i];
-        double k = log(2) / ZHL16N[i].t;
-        double t = time;
-
-        ds->pn2[i] = po + (pio - po) * (1 - exp(-k * t));
-    }
+    propagator_t scratch;
+    segment_const(&ds->tissues, ds->conf->model, decoconf_propagator(ds->conf, time, &scratch), depth, gas);
 
     /* TODO add CNS */
     /* TODO add OTU */
@@ -192,102 +482,128 @@ double add_segment_const(decostate_t *ds, double depth, double time, const gas_t
     return time;
 }
 
-double get_gf(const decostate_t *ds, double depth)
+/* minutes to ascend between two depths at 9m/min */
+double decoconf_ascent_time(const decoconf_t *conf, double from, double to)
+{
+    return fabs(from - to) / msw_to_bar(9);
+}
+
+/*
+ * model_propagator() that also knows the ascent between the stops of conf,
+ * whose time differs with the rounding of the stop depths.
+ */
+const propagator_t *decoconf_propagator(const decoconf_t *conf, double time, propagator_t *scratch)
 {
-    const unsigned char lo = ds->gflo;
-    const unsigned char hi = ds->gfhi;
+    if (propagator_serves(&conf->stop_ascent, time))
+        return &conf->stop_ascent;
+
+    return model_propagator(conf->model, time, scratch);
+}
 
-    if (ds->firststop == -1)
+double decoconf_gf(const decoconf_t *conf, double firststop, double depth)
+{
+    const unsigned char lo = conf->gflo;
+    const unsigned char hi = conf->gfhi;
+
+    if (firststop == -1)
         return lo;
 
-    if (depth <= SURFACE_PRESSURE)
+    if (depth <= opendeco_ctx_surface_pressure(conf->ctx))
         return hi;
 
-    if (depth >= ds->firststop)
+    if (depth >= firststop)
         return lo;
 
     /* interpolate lo and hi between first stop and last stop */
-    return hi - (hi - lo) * gauge_depth(depth) / gauge_depth(ds->firststop);
+    return hi - (hi - lo) * gauge_depth(conf->ctx, depth) / gauge_depth(conf->ctx, firststop);
 }
 
-double ceiling(const decostate_t *ds, double gf)
+double get_gf(const decostate_t *ds, double depth)
 {
-    double c = 0;
-    gf /= 100;
-
-    for (int i = 0; i < 16; i++) {
-        /* n2 a and b values */
-        double an = ZHL16N[i].a[ALGO_VER];
-        double bn = ZHL16N[i].b;
-
-        /* he a and b values */
-        double ah = ZHL16He[i].a;
-        double bh = ZHL16He[i].b;
-
-        /* scale n2 and he values for a and b proportional to their pressure */
-        double pn2 = ds->pn2[i];
-        double phe = ds->phe[i];
-
-        double a = ((an * pn2) + (ah * phe)) / (pn2 + phe);
-        double b = ((bn * pn2) + (bh * phe)) / (pn2 + phe);
+    return decoconf_gf(ds->conf, ds->firststop, depth);
+}
 
-        /* update ceiling */
-        c = max(c, ((pn2 + phe) - (a * gf)) / (gf / b + 1 - gf));
-    }
+double ceiling(const decostate_t *ds, double gf)
+{
+    return tissues_ceiling(&ds->tissues, ds->conf->model, gf);
+}
 
-    return c;
+void ceilings(const decostate_t *ds, const double *gf, int n, double *c)
+{
+    tissues_ceilings(&ds->tissues, ds->conf->model, gf, n, c);
 }
 
 double gf99(const decostate_t *ds, double depth)
 {
-    double gf = 0;
+    return kernel_gf99(&ds->tissues, ds->conf->model, depth) * 100;
+}
 
-    for (int i = 0; i < 16; i++) {
-        /* n2 a and b values */
-        double an = ZHL16N[i].a[ALGO_VER];
-        double bn = ZHL16N[i].b;
+/* the compartment with the deepest ceiling at gf, numbered from 0 */
+int controlling_compartment(const decostate_t *ds, double gf)
+{
+    const model_t *m = ds->conf->model;
+    const double f = gf / 100;
 
-        /* he a and b values */
-        double ah = ZHL16He[i].a;
-        double bh = ZHL16He[i].b;
+    int controlling = 0;
+    double c_max = -INFINITY;
+
+    for (int i = 0; i < 16; i++) {
+        double pn2 = ds->tissues.pn2[i];
+        double phe = ds->tissues.phe[i];
 
         /* scale n2 and he values for a and b proportional to their pressure */
-        double pn2 = ds->pn2[i];
-        double phe = ds->phe[i];
+        double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+        double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
 
-        double a = ((an * pn2) + (ah * phe)) / (pn2 + phe);
-        double b = ((bn * pn2) + (bh * phe)) / (pn2 + phe);
+        double c = ((pn2 + phe) - (a * f)) / (f / b + 1 - f);
 
-        /* update gf99 */
-        gf = max(gf, (pn2 + phe - depth) / (a + depth / b - depth));
+        if (c > c_max) {
+            c_max = c;
+            controlling = i;
+        }
     }
 
-    return gf * 100;
+    return controlling;
 }
 
-void init_tissues(decostate_t *ds)
+void init_tissues(tissues_t *t, const opendeco_ctx *ctx)
 {
-    const double pn2 = 0.79 * (SURFACE_PRESSURE - P_WV);
-    const double phe = 0.00 * (SURFACE_PRESSURE - P_WV);
+    const double surface_pressure = opendeco_ctx_surface_pressure(ctx);
+    const double p_wv = opendeco_ctx_model(ctx)->p_wv;
+
+    const double pn2 = 0.79 * (surface_pressure - p_wv);
+    const double phe = 0.00 * (surface_pressure - p_wv);
 
     for (int i = 0; i < 16; i++)
-        ds->pn2[i] = pn2;
+        t->pn2[i] = pn2;
 
     for (int i = 0; i < 16; i++)
-        ds->phe[i] = phe;
+        t->phe[i] = phe;
+
+    t->he_loaded = 0;
 }
 
-void init_decostate(decostate_t *ds, unsigned char gflo, unsigned char gfhi, double ceil_multiple)
+void init_decoconf(decoconf_t *conf, const opendeco_ctx *ctx, unsigned char gflo, unsigned char gfhi,
+                   double ceil_multiple)
 {
     assert(gflo <= gfhi);
 
-    init_tissues(ds);
+    conf->ctx = ctx;
+    conf->model = opendeco_ctx_model(ctx);
+    conf->gflo = gflo;
+    conf->gfhi = gfhi;
+    conf->ceil_multiple = ceil_multiple;
+
+    kernel_propagate(&conf->stop_ascent, conf->model, ceil_multiple / msw_to_bar(9));
+}
+
+void init_decostate(decostate_t *ds, const decoconf_t *conf)
+{
+    init_tissues(&ds->tissues, conf->ctx);
 
-    ds->gflo = gflo;
-    ds->gfhi = gfhi;
+    ds->conf = conf;
     ds->firststop = -1;
     ds->max_depth = 0;
-    ds->ceil_multiple = ceil_multiple;
 }
 
 double ppO2(double depth, const gas_t *gas)
@@ -21,24 +21,77 @@
 #define END_MAX_DEFAULT 4.01325
 
 #define LAST_STOP_AT_SIX_DEFAULT 0
+#define SWITCH_INTERMEDIATE_DEFAULT 1
 
 #define MOD_AUTO 0
 
+#define MODEL_MINUTES 64 /* whole minute propagators a model keeps */
+
 /* types */
+typedef struct opendeco_ctx opendeco_ctx;
+
 enum ALGO {
     ZHL_16A = 0,
     ZHL_16B = 1,
     ZHL_16C = 2,
 };
 
-typedef struct decostate_t {
-    double pn2[16];
+typedef struct propagator_t {
+    double he_e[16]; /* exp(-k * time) for every compartment */
+    double n2_e[16];
+    double time;
+    int kernel; /* that computed the factors, see kernel_select() */
+} __attribute__((aligned(64))) propagator_t;
+
+typedef struct model_t {
+    /* helium compartments */
+    double he_k[16];    /* rate constant, ln(2) / half-time */
+    double he_kinv[16]; /* reciprocal of the rate constant */
+    double he_a[16];
+    double he_b[16];
+
+    /* nitrogen compartments */
+    double n2_k[16];
+    double n2_kinv[16];
+    double n2_a[16];
+    double n2_b[16];
+
+    enum ALGO algo;
+    double p_wv;
+
+    propagator_t minutes[MODEL_MINUTES]; /* deco stops, gas switches and bottom times of 1 to MODEL_MINUTES */
+} __attribute__((aligned(64))) model_t;
+
+typedef struct tissues_t {
     double phe[16];
+    double pn2[16];
+    int he_loaded; /* zero while every phe[] is known to be zero */
+} __attribute__((aligned(64))) tissues_t;
+
+/* affine tissue update p' = mul * p + add of one or more consecutive segments */
+typedef struct segment_op_t {
+    double he_mul[16];
+    double he_add[16];
+    double n2_mul[16];
+    double n2_add[16];
+    double max_depth;
+    int he_loaded; /* the segments inspire helium */
+} __attribute__((aligned(64))) segment_op_t;
+
+typedef struct decoconf_t {
+    const opendeco_ctx *ctx;
+    const model_t *model;
     unsigned char gflo;
     unsigned char gfhi;
+    double ceil_multiple;
+    propagator_t stop_ascent; /* from one stop to the next, see decoconf_ascent_time() */
+} decoconf_t;
+
+typedef struct decostate_t {
+    tissues_t tissues;
+    const decoconf_t *conf;
     double firststop;
     double max_depth;
-    double ceil_multiple;
 } decostate_t;
 
 typedef struct gas_t {
@@ -49,35 +102,74 @@ typedef struct gas_t {
 } gas_t;
 
 /* global variables */
-extern enum ALGO ALGO_VER;
 extern double SURFACE_PRESSURE;
-extern double P_WV;
 
 extern double PO2_MAX;
 extern double END_MAX;
 
 extern int LAST_STOP_AT_SIX;
+extern int SWITCH_INTERMEDIATE;
 
 /* functions */
+opendeco_ctx *opendeco_ctx_new(enum ALGO algo, double p_wv);
+void opendeco_ctx_free(opendeco_ctx *ctx);
+
+void opendeco_ctx_set_surface_pressure(opendeco_ctx *ctx, double surface_pressure);
+void opendeco_ctx_set_po2_max(opendeco_ctx *ctx, double po2_max);
+void opendeco_ctx_set_end_max(opendeco_ctx *ctx, double end_max);
+void opendeco_ctx_set_last_stop_at_six(opendeco_ctx *ctx, int last_stop_at_six);
+void opendeco_ctx_set_switch_intermediate(opendeco_ctx *ctx, int switch_intermediate);
+
+const model_t *opendeco_ctx_model(const opendeco_ctx *ctx);
+double opendeco_ctx_surface_pressure(const opendeco_ctx *ctx);
+double opendeco_ctx_po2_max(const opendeco_ctx *ctx);
+double opendeco_ctx_end_max(const opendeco_ctx *ctx);
+int opendeco_ctx_last_stop_at_six(const opendeco_ctx *ctx);
+int opendeco_ctx_switch_intermediate(const opendeco_ctx *ctx);
+
 double bar_to_msw(double bar);
 double msw_to_bar(double msw);
-double abs_depth(double gd);
-double gauge_depth(double ad);
+double abs_depth(const opendeco_ctx *ctx, double gd);
+double gauge_depth(const opendeco_ctx *ctx, double ad);
 
-gas_t gas_new(unsigned char o2, unsigned char he, double mod);
+gas_t gas_new(const opendeco_ctx *ctx, unsigned char o2, unsigned char he, double mod);
 int gas_equal(const gas_t *g1, const gas_t *g2);
 unsigned char gas_o2(const gas_t *gas);
 unsigned char gas_he(const gas_t *gas);
 unsigned char gas_n2(const gas_t *gas);
 double gas_mod(const gas_t *gas);
 
+void model_init(model_t *model, enum ALGO algo, double p_wv);
+const propagator_t *model_propagator(const model_t *model, double time, propagator_t *scratch);
+
+void tissues_add_segment_ascdec(tissues_t *t, const model_t *m, double dstart, double dend, double time,
+                                const gas_t *gas);
+void tissues_add_segment_const(tissues_t *t, const model_t *m, double depth, double time, const gas_t *gas);
+double tissues_ceiling(const tissues_t *t, const model_t *m, double gf);
+void tissues_ceilings(const tissues_t *t, const model_t *m, const double *gf, int n, double *c);
+
+void segment_op_identity(segment_op_t *op);
+void segment_op_ascdec(segment_op_t *op, const model_t *m, double dstart, double dend, double time, const gas_t *gas);
+void segment_op_const(segment_op_t *op, const model_t *m, double depth, double time, const gas_t *gas);
+void segment_op_compose(segment_op_t *op, const segment_op_t *first, const segment_op_t *second);
+void tissues_apply_segment_op(tissues_t *restrict t, const segment_op_t *restrict op);
+void apply_segment_op(decostate_t *ds, const segment_op_t *op);
+
 double add_segment_ascdec(decostate_t *ds, double dstart, double dend, double time, const gas_t *gas);
 double add_segment_const(decostate_t *ds, double depth, double time, const gas_t *gas);
+double decoconf_ascent_time(const decoconf_t *conf, double from, double to);
+const propagator_t *decoconf_propagator(const decoconf_t *conf, double time, propagator_t *scratch);
+double decoconf_gf(const decoconf_t *conf, double firststop, double depth);
 double get_gf(const decostate_t *ds, double depth);
 double ceiling(const decostate_t *ds, double gf);
+void ceilings(const decostate_t *ds, const double *gf, int n, double *c);
 double gf99(const decostate_t *ds, double depth);
+int controlling_compartment(const decostate_t *ds, double gf);
 
-void init_decostate(decostate_t *ds, unsigned char gflo, unsigned char gfhi, double ceil_multiple);
+void init_tissues(tissues_t *t, const opendeco_ctx *ctx);
+void init_decoconf(decoconf_t *conf, const opendeco_ctx *ctx, unsigned char gflo, unsigned char gfhi,
+                   double ceil_multiple);
+void init_decostate(decostate_t *ds, const decoconf_t *conf);
 
 double ppO2(double depth, const gas_t *gas);
 double end(double depth, const gas_t *gas);
@@ -0,0 +1,510 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decimate.h"
+#include "divelog.h"
+#include "replay.h"
+
+/*
+ * Read dive computer logs as CSV of time,depth[,gas] samples. Time is in
+ * seconds or mm:ss, depth in meters and the optional gas in the notation of
+ * the -g option. A first line that does not start with a digit is taken as a
+ * header, empty lines and lines starting with # are skipped. The file is read
+ * in chunks into a fixed buffer, so memory does not depend on its length.
+ */
+int init_divelog(divelog_t *log, FILE *file, const opendeco_ctx *ctx, const gas_t *gas)
+{
+    *log = (divelog_t){
+        .file = file,
+        .ctx = ctx,
+        .gas = *gas,
+    };
+
+    /* room for the terminator of a last line without a newline */
+    log->buf = malloc(DIVELOG_BUFFER + 1);
+
+    return log->buf ? 0 : -1;
+}
+
+void free_divelog(divelog_t *log)
+{
+    free(log->buf);
+    log->buf = NULL;
+}
+
+/* the next line without its newline, returns 0 at the end and -1 if the line does not fit */
+static int next_line(divelog_t *log, char **line)
+{
+    for (;;) {
+        char *nl = memchr(log->buf + log->start, '\n', log->end - log->start);
+
+        if (nl || (log->eof && log->start < log->end)) {
+            if (!nl)
+                nl = log->buf + log->end;
+
+            *nl = '\0';
+            *line = log->buf + log->start;
+            log->start = min((size_t) (nl - log->buf + 1), log->end);
+            log->line++;
+            return 1;
+        }
+
+        if (log->eof)
+            return 0;
+
+        /* move the partial line to the front and refill behind it */
+        memmove(log->buf, log->buf + log->start, log->end - log->start);
+        log->end -= log->start;
+        log->start = 0;
+
+        if (log->end == DIVELOG_BUFFER) {
+            log->line++;
+            return -1;
+        }
+
+        size_t n = fread(log->buf + log->end, 1, DIVELOG_BUFFER - log->end, log->file);
+        log->end += n;
+
+        if (n == 0) {
+            if (ferror(log->file))
+                return -1;
+
+            log->eof = 1;
+        }
+    }
+}
+
+static char *trim(char *str)
+{
+    while (isspace((unsigned char) *str))
+        str++;
+
+    char *end = str + strlen(str);
+
+    while (end > str && isspace((unsigned char) end[-1]))
+        *--end = '\0';
+
+    return str;
+}
+
+/* seconds or mm:ss in minutes, -1 if field is neither */
+static double parse_time(char *field)
+{
+    char *end;
+    double time = strtod(field, &end);
+
+    if (end == field)
+        return -1;
+
+    if (*end == ':') {
+        char *ss = end + 1;
+        double seconds = strtod(ss, &end);
+
+        if (end == ss || seconds < 0 || seconds >= 60)
+            return -1;
+
+        time = time * 60 + seconds;
+    }
+
+    return *end || !isfinite(time) || time < 0 ? -1 : time / 60;
+}
+
+/* a whole percentage up to 100, -1 if str does not start with one */
+static int parse_percent(char *str, char **end)
+{
+    if (!isdigit((unsigned char) *str))
+        return -1;
+
+    long percent = strtol(str, end, 10);
+
+    return percent > 100 ? -1 : percent;
+}
+
+/* a gas in the notation of scan_gas(), -1 unless it is a mix gas_new() accepts */
+static int parse_gas(const opendeco_ctx *ctx, char *field, gas_t *gas)
+{
+    char *end = "";
+    int o2 = -1;
+    int he = 0;
+
+    if (!strcmp(field, "Air"))
+        o2 = 21;
+    else if (!strcmp(field, "Oxygen"))
+        o2 = 100;
+    else if (!strncmp(field, "EAN", strlen("EAN")))
+        o2 = parse_percent(field + strlen("EAN"), &end);
+    else if (!strncmp(field, "Nitrox", strlen("Nitrox")))
+        o2 = parse_percent(trim(field + strlen("Nitrox")), &end);
+    else if ((o2 = parse_percent(field, &end)) >= 0 && *end == '/')
+        he = parse_percent(end + 1, &end);
+
+    if (*end || o2 < 1 || he < 0 || he > 100 - o2)
+        return -1;
+
+    *gas = gas_new(ctx, o2, he, MOD_AUTO);
+
+    return 0;
+}
+
+static int parse_sample(divelog_t *log, char *line, divelog_sample_t *sample)
+{
+    char *fields[3] = {line, NULL, NULL};
+
+    for (int i = 1; i < (int) len(fields); i++) {
+        fields[i] = strchr(fields[i - 1], ',');
+
+        if (!fields[i])
+            break;
+
+        *fields[i]++ = '\0';
+    }
+
+    if (!fields[1])
+        return -1;
+
+    double time = parse_time(trim(fields[0]));
+
+    char *depth_field = trim(fields[1]);
+    char *end;
+    double depth = strtod(depth_field, &end);
+
+    if (time < 0 || time < log->time || end == depth_field || *end || !isfinite(depth) || depth < 0)
+        return -1;
+
+    char *gas_field = fields[2] ? trim(fields[2]) : "";
+
+    if (*gas_field && parse_gas(log->ctx, gas_field, &log->gas))
+        return -1;
+
+    log->time = time;
+
+    sample->time = time;
+    sample->depth = abs_depth(log->ctx, msw_to_bar(depth));
+    sample->gas = log->gas;
+
+    return 0;
+}
+
+/* the next sample, returns 0 at the end of the log and -1 on an invalid line */
+int divelog_read(divelog_t *log, divelog_sample_t *sample)
+{
+    char *line;
+    int ret;
+
+    while ((ret = next_line(log, &line)) > 0) {
+        line = trim(line);
+
+        if (!*line || *line == '#')
+            continue;
+
+        if (log->line == 1 && !isdigit((unsigned char) *line))
+            continue;
+
+        if (parse_sample(log, line, sample))
+            return -1;
+
+        log->nof_samples++;
+        return 1;
+    }
+
+    return ret;
+}
+
+/* the segment from the previous sample, breathed on its gas, an instantaneous depth change adds none */
+static void replay_segment(decostate_t *ds, divelog_t *log, double depth, double to, double time, const gas_t *gas)
+{
+    if (time <= 0)
+        return;
+
+    if (to != depth)
+        add_segment_ascdec(ds, depth, to, time, gas);
+    else
+        add_segment_const(ds, depth, time, gas);
+
+    log->nof_segments++;
+}
+
+/* the sample at time and depth once ds breathed gas to get there */
+void init_log_sample(log_sample_t *s, const decostate_t *ds, double time, double depth, const gas_t *gas)
+{
+    const double surface = abs_depth(ds->conf->ctx, 0);
+
+    *s = (log_sample_t){
+        .time = time,
+        .depth = depth,
+        .gas = gas,
+        .ceiling = ceiling(ds, ds->conf->gfhi),
+        .gf99 = gf99(ds, depth),
+        .surf_gf = gf99(ds, surface),
+        .compartment = controlling_compartment(ds, ds->conf->gfhi),
+    };
+}
+
+static void report_sample(const decostate_t *ds, const log_callback_t *cb, double time, double depth,
+                          const gas_t *gas)
+{
+    if (!cb || !cb->fn)
+        return;
+
+    log_sample_t s;
+    init_log_sample(&s, ds, time, depth, gas);
+
+    cb->fn(ds, &s, cb->arg);
+}
+
+/* decimate the samples buffered in wp and replay the segments that are left */
+static int replay_chunk(decostate_t *ds, divelog_t *log, waypoint_t *wp, int n, double *time, double *depth,
+                        const log_callback_t *cb)
+{
+    int nof_kept = decimate_dive(wp, wp, n, *depth, log->tolerance);
+
+    if (nof_kept < 0)
+        return -1;
+
+    for (int i = 0; i < nof_kept; i++) {
+        replay_segment(ds, log, *depth, wp[i].depth, wp[i].time, wp[i].gas);
+
+        *time += wp[i].time;
+        *depth = wp[i].depth;
+
+        report_sample(ds, cb, *time, *depth, wp[i].gas);
+    }
+
+    return 0;
+}
+
+/*
+ * Buffer up to DIVELOG_CHUNK samples of log as waypoints in wp, every one
+ * breathed on the gas of the sample before it, which is kept in gasses.
+ * Returns their number, 0 at the end of the log and -1 on an invalid line.
+ */
+static int read_chunk(divelog_t *log, waypoint_t *wp, gas_t *gasses, double *last_time, gas_t *gas)
+{
+    divelog_sample_t sample;
+    int n = 0;
+    int ret = 0;
+
+    while (n < DIVELOG_CHUNK && (ret = divelog_read(log, &sample)) > 0) {
+        gasses[n] = *gas;
+        wp[n] = (waypoint_t){.depth = sample.depth, .time = sample.time - *last_time, .gas = &gasses[n]};
+        n++;
+
+        *last_time = sample.time;
+        *gas = sample.gas;
+    }
+
+    return ret < 0 ? -1 : n;
+}
+
+/*
+ * Replay log like replay_log(), but merge its samples into fewer segments
+ * with decimate_dive() first. Chunks of DIVELOG_CHUNK samples are decimated
+ * at a time, so memory still does not depend on the length of the log.
+ */
+static int replay_log_decimated(decostate_t *ds, divelog_t *log, const log_callback_t *cb)
+{
+    waypoint_t *wp = malloc(DIVELOG_CHUNK * sizeof(waypoint_t));
+    gas_t *gasses = malloc(DIVELOG_CHUNK * sizeof(gas_t));
+
+    if (!wp || !gasses) {
+        free(wp);
+        free(gasses);
+        return -1;
+    }
+
+    double time = 0;
+    double depth = abs_depth(ds->conf->ctx, 0);
+    double last_time = 0;
+    gas_t gas = log->gas;
+
+    int n;
+
+    while ((n = read_chunk(log, wp, gasses, &last_time, &gas)) > 0) {
+        if (replay_chunk(ds, log, wp, n, &time, &depth, cb)) {
+            n = -1;
+            break;
+        }
+    }
+
+    free(wp);
+    free(gasses);
+
+    return n < 0 ? -1 : log->nof_samples;
+}
+
+/* sample wp of a chunk replay_dive_from() replayed, at is ds holding the tissues of the sample */
+static void report_replay_sample(decostate_t *at, const log_callback_t *cb, const replay_sample_t *rs, double time,
+                                 const waypoint_t *wp)
+{
+    if (!cb || !cb->fn)
+        return;
+
+    for (int i = 0; i < 16; i++) {
+        at->tissues.phe[i] = rs->phe[i];
+        at->tissues.pn2[i] = rs->pn2[i];
+    }
+
+    at->tissues.he_loaded = rs->he_loaded;
+
+    if (wp->time > 0)
+        at->max_depth = max(at->max_depth, wp->depth);
+
+    log_sample_t s = {
+        .time = time,
+        .depth = wp->depth,
+        .gas = wp->gas,
+        .ceiling = rs->ceiling,
+        .gf99 = rs->gf99,
+        .surf_gf = rs->surf_gf,
+        .compartment = rs->compartment,
+    };
+
+    cb->fn(at, &s, cb->arg);
+}
+
+/*
+ * Replay log like replay_log(), but a chunk of DIVELOG_CHUNK samples at a
+ * time with replay_dive_from() on pool, decimated first if log->tolerance is
+ * set. Every chunk is buffered, replayed and then reported to cb, so memory
+ * still does not depend on the length of the log.
+ */
+static int replay_log_pooled(decostate_t *ds, divelog_t *log, const log_callback_t *cb, pool_t *pool)
+{
+    waypoint_t *wp = malloc(DIVELOG_CHUNK * sizeof(waypoint_t));
+    gas_t *gasses = malloc(DIVELOG_CHUNK * sizeof(gas_t));
+    replay_sample_t *samples = malloc(DIVELOG_CHUNK * sizeof(replay_sample_t));
+
+    if (!wp || !gasses || !samples) {
+        free(wp);
+        free(gasses);
+        free(samples);
+        return -1;
+    }
+
+    double time = 0;
+    double depth = abs_depth(ds->conf->ctx, 0);
+    double last_time = 0;
+    gas_t gas = log->gas;
+
+    int n;
+
+    while ((n = read_chunk(log, wp, gasses, &last_time, &gas)) > 0) {
+        decostate_t at = *ds;
+
+        if (log->tolerance > 0 && (n = decimate_dive(wp, wp, n, depth, log->tolerance)) < 0)
+            break;
+
+        if (replay_dive_from(ds, depth, wp, n, samples, pool)) {
+            n = -1;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            time += wp[i].time;
+            log->nof_segments += wp[i].time > 0;
+
+            report_replay_sample(&at, cb, &samples[i], time, &wp[i]);
+        }
+
+        if (n > 0)
+            depth = wp[n - 1].depth;
+    }
+
+    free(wp);
+    free(gasses);
+    free(samples);
+
+    return n < 0 ? -1 : log->nof_samples;
+}
+
+/*
+ * Replay the samples of log on ds like simulate_dive() replays waypoints,
+ * starting at the surface at time zero. Every segment is breathed on the gas
+ * of the sample it starts at. After every sample cb receives the ceiling at
+ * gfhi, gf99 at depth and at the surface and the controlling compartment.
+ * Only one sample is held at a time. If log->tolerance is set, the samples
+ * are decimated first and cb only receives the samples that are kept. With
+ * a pool of more than one thread the samples are replayed in chunks with
+ * replay_dive_from() instead, whose results match to within rounding.
+ * Returns the number of samples, or -1 if a line is invalid, in which case
+ * log->line is that line, or if memory cannot be allocated.
+ */
+int replay_log(decostate_t *ds, divelog_t *log, const log_callback_t *cb, pool_t *pool)
+{
+    if (pool_threads(pool) > 1)
+        return replay_log_pooled(ds, log, cb, pool);
+
+    if (log->tolerance > 0)
+        return replay_log_decimated(ds, log, cb);
+
+    double time = 0;
+    double depth = abs_depth(ds->conf->ctx, 0);
+    gas_t gas = log->gas;
+
+    divelog_sample_t sample;
+    int ret;
+
+    while ((ret = divelog_read(log, &sample)) > 0) {
+        replay_segment(ds, log, depth, sample.depth, sample.time - time, &gas);
+        report_sample(ds, cb, sample.time, sample.depth, &gas);
+
+        time = sample.time;
+        depth = sample.depth;
+        gas = sample.gas;
+    }
+
+    return ret < 0 ? -1 : log->nof_samples;
+}
+
+/*
+ * Append log to the profile container w as a dive of its own, decimated
+ * first if log->tolerance is set. A sample at the time of the previous one
+ * is kept only if it changes depth, simulate_dive_packed() replays it as the
+ * same instantaneous jump replay_log() does. Returns the
+ * number of samples, or -1 if a line is invalid, in which case log->line is
+ * that line, or if w cannot be written.
+ */
+int convert_log(profile_writer_t *w, divelog_t *log)
+{
+    waypoint_t *wp = malloc(DIVELOG_CHUNK * sizeof(waypoint_t));
+    gas_t *gasses = malloc(DIVELOG_CHUNK * sizeof(gas_t));
+
+    if (!wp || !gasses || profile_writer_dive(w)) {
+        free(wp);
+        free(gasses);
+        return -1;
+    }
+
+    double depth = abs_depth(log->ctx, 0);
+    double last_time = 0;
+    gas_t gas = log->gas;
+
+    int n;
+
+    while ((n = read_chunk(log, wp, gasses, &last_time, &gas)) > 0) {
+        int nof_kept = log->tolerance > 0 ? decimate_dive(wp, wp, n, depth, log->tolerance) : n;
+
+        for (int i = 0; i < nof_kept && n >= 0; i++) {
+            /* samples without time only matter if they jump */
+            if ((wp[i].time > 0 || wp[i].depth != depth) && profile_writer_add(w, &wp[i]))
+                n = -1;
+
+            log->nof_segments += wp[i].time > 0;
+            depth = wp[i].depth;
+        }
+
+        if (nof_kept < 0 || n < 0) {
+            n = -1;
+            break;
+        }
+    }
+
+    free(wp);
+    free(gasses);
+
+    return n < 0 ? -1 : log->nof_samples;
+}
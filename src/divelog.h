@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef DIVELOG_H
+#define DIVELOG_H
+
+#include <stdio.h>
+
+#include "deco.h"
+#include "pool.h"
+#include "profile.h"
+
+#define DIVELOG_BUFFER 65536 /* bytes, also the longest line */
+#define DIVELOG_CHUNK 4096   /* samples decimated at once */
+
+/* types */
+typedef struct divelog_t {
+    FILE *file;
+    const opendeco_ctx *ctx;
+
+    gas_t gas;      /* of the last sample, an empty gas column keeps it */
+    double time;    /* of the last sample in minutes */
+    int line;       /* of the last line read, for error messages */
+    int nof_samples;
+    int nof_segments; /* added by replay_log() */
+
+    double tolerance; /* of compartment pressures in bar when decimating, 0 keeps every sample */
+
+    char *buf;
+    size_t start; /* the unparsed part of buf */
+    size_t end;
+    int eof;
+} divelog_t;
+
+typedef struct divelog_sample_t {
+    double time;  /* minutes */
+    double depth; /* absolute pressure */
+    gas_t gas;
+} divelog_sample_t;
+
+typedef struct log_sample_t {
+    double time;
+    double depth;
+    const gas_t *gas; /* breathed since the previous sample, valid during the callback */
+
+    double ceiling; /* at gfhi */
+    double gf99;
+    double surf_gf;
+    int compartment; /* that controls the ceiling, numbered from 0 */
+} log_sample_t;
+
+typedef struct log_callback_t {
+    void (*fn)(const decostate_t *ds, const log_sample_t *sample, void *arg);
+    void *arg;
+} log_callback_t;
+
+/* functions */
+int init_divelog(divelog_t *log, FILE *file, const opendeco_ctx *ctx, const gas_t *gas);
+void free_divelog(divelog_t *log);
+
+int divelog_read(divelog_t *log, divelog_sample_t *sample);
+void init_log_sample(log_sample_t *s, const decostate_t *ds, double time, double depth, const gas_t *gas);
+int replay_log(decostate_t *ds, divelog_t *log, const log_callback_t *cb, pool_t *pool);
+int convert_log(profile_writer_t *w, divelog_t *log);
+
+#endif /* end of include guard: DIVELOG_H */
@@ -0,0 +1,917 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <pthread.h>
+
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*segment_const_fn)(tissues_t *, const propagator_t *, double, double);
+typedef void (*segment_ascdec_fn)(tissues_t *, const model_t *, const propagator_t *, double, double, double, double,
+                                  double);
+
+typedef void (*ceilings_fn)(const tissues_t *, const model_t *, const double *, int, double *);
+
+typedef struct kernel_ops_t {
+    void (*propagate)(propagator_t *, const model_t *, double);
+    segment_const_fn segment_const[GAS_CLASSES];
+    segment_ascdec_fn segment_ascdec[GAS_CLASSES];
+    double (*ceiling)(const tissues_t *, const model_t *, double);
+    double (*gf99)(const tissues_t *, const model_t *, double);
+    double (*ceiling_n2)(const tissues_t *, const model_t *, double);
+    double (*gf99_n2)(const tissues_t *, const model_t *, double);
+    ceilings_fn ceilings;
+    ceilings_fn ceilings_n2;
+} kernel_ops_t;
+
+/*
+ * scalar reference kernels, every vectorized kernel below must agree with
+ * these within the accuracy of its exp() approximation. The segment updates,
+ * ceiling and gf99 reductions perform the same operations in the same order
+ * in every kernel and are therefore bit-identical to the reference for the
+ * same propagator.
+ */
+static void propagate_scalar(propagator_t *p, const model_t *m, double t)
+{
+    for (int i = 0; i < 16; i++)
+        p->he_e[i] = exp(-m->he_k[i] * t);
+
+    for (int i = 0; i < 16; i++)
+        p->n2_e[i] = exp(-m->n2_k[i] * t);
+}
+
+static void segment_const_scalar_16(double *p, const double *e, double pio)
+{
+    for (int i = 0; i < 16; i++)
+        p[i] = p[i] + (pio - p[i]) * (1 - e[i]);
+}
+
+static void segment_ascdec_scalar_16(double *p, const double *e, const double *kinv, double pio, double r, double t)
+{
+    for (int i = 0; i < 16; i++)
+        p[i] = pio + r * (t - kinv[i]) - (pio - p[i] - (r * kinv[i])) * e[i];
+}
+
+/*
+ * Segment updates of an inert gas that is not inspired, the tissues only
+ * off-gas. Both round exactly like the full updates with zero pio and rate.
+ */
+static void decay_const_scalar_16(double *p, const double *e)
+{
+    for (int i = 0; i < 16; i++)
+        p[i] = p[i] - p[i] * (1 - e[i]);
+}
+
+static void decay_ascdec_scalar_16(double *p, const double *e)
+{
+    for (int i = 0; i < 16; i++)
+        p[i] = p[i] * e[i];
+}
+
+static void segment_const_scalar(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_scalar_16(ts->phe, p->he_e, pio_he);
+    segment_const_scalar_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_n2_scalar(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_scalar_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_heliox_scalar(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_scalar_16(ts->phe, p->he_e, pio_he);
+    decay_const_scalar_16(ts->pn2, p->n2_e);
+}
+
+static void segment_ascdec_scalar(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                  double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_scalar_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    segment_ascdec_scalar_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_n2_scalar(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                     double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_scalar_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_heliox_scalar(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                         double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_scalar_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    decay_ascdec_scalar_16(ts->pn2, p->n2_e);
+}
+
+static double ceiling_scalar(const tissues_t *ts, const model_t *m, double gf)
+{
+    double c = 0;
+
+    for (int i = 0; i < 16; i++) {
+        double pn2 = ts->pn2[i];
+        double phe = ts->phe[i];
+
+        /* scale n2 and he values for a and b proportional to their pressure */
+        double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+        double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+        c = max(c, ((pn2 + phe) - (a * gf)) / (gf / b + 1 - gf));
+    }
+
+    return c;
+}
+
+static double gf99_scalar(const tissues_t *ts, const model_t *m, double depth)
+{
+    double gf = 0;
+
+    for (int i = 0; i < 16; i++) {
+        double pn2 = ts->pn2[i];
+        double phe = ts->phe[i];
+
+        /* scale n2 and he values for a and b proportional to their pressure */
+        double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+        double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+        gf = max(gf, (pn2 + phe - depth) / (a + depth / b - depth));
+    }
+
+    return gf;
+}
+
+/* ceiling and gf99 of tissues without helium, the a and b values need no blending */
+static double ceiling_n2_scalar(const tissues_t *ts, const model_t *m, double gf)
+{
+    double c = 0;
+
+    for (int i = 0; i < 16; i++)
+        c = max(c, (ts->pn2[i] - (m->n2_a[i] * gf)) / (gf / m->n2_b[i] + 1 - gf));
+
+    return c;
+}
+
+static double gf99_n2_scalar(const tissues_t *ts, const model_t *m, double depth)
+{
+    double gf = 0;
+
+    for (int i = 0; i < 16; i++)
+        gf = max(gf, (ts->pn2[i] - depth) / (m->n2_a[i] + depth / m->n2_b[i] - depth));
+
+    return gf;
+}
+
+/*
+ * ceilings at n gradient factors in a single pass over the compartments, the
+ * blended a and b values of a compartment are shared by all gradient factors
+ */
+static void ceilings_scalar(const tissues_t *ts, const model_t *m, const double *gf, int n, double *c)
+{
+    for (int j = 0; j < n; j++)
+        c[j] = 0;
+
+    for (int i = 0; i < 16; i++) {
+        double pn2 = ts->pn2[i];
+        double phe = ts->phe[i];
+
+        double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+        double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+        for (int j = 0; j < n; j++)
+            c[j] = max(c[j], ((pn2 + phe) - (a * gf[j])) / (gf[j] / b + 1 - gf[j]));
+    }
+}
+
+static void ceilings_n2_scalar(const tissues_t *ts, const model_t *m, const double *gf, int n, double *c)
+{
+    for (int j = 0; j < n; j++)
+        c[j] = 0;
+
+    for (int i = 0; i < 16; i++)
+        for (int j = 0; j < n; j++)
+            c[j] = max(c[j], (ts->pn2[i] - (m->n2_a[i] * gf[j])) / (gf[j] / m->n2_b[i] + 1 - gf[j]));
+}
+
+#ifdef KERNEL_X86
+
+/*
+ * tissues_t, propagator_t and model_t are 64-byte aligned and consist of 16
+ * element arrays, so the vector kernels below can use aligned loads and stores.
+ */
+
+/*
+ * vector exp(x): x = n * ln(2) + r with |r| <= ln(2) / 2, exp(r) is evaluated
+ * as a degree 13 Taylor polynomial and 2^n is built directly in the exponent
+ * bits. The relative error is within a few ulp over the clamped input range.
+ */
+#define EXP_MIN -708.0
+#define EXP_MAX 709.0
+#define EXP_LOG2E 1.44269504088896340736
+#define EXP_LN2_HI 6.93147180369123816490e-01
+#define EXP_LN2_LO 1.90821492927058770002e-10
+
+static const double EXP_POLY[] = {
+    1 / 6227020800.0, 1 / 479001600.0, 1 / 39916800.0, 1 / 3628800.0, 1 / 362880.0, 1 / 40320.0, 1 / 5040.0,
+    1 / 720.0,        1 / 120.0,       1 / 24.0,       1 / 6.0,        1 / 2.0,      1.0,         1.0,
+};
+
+__attribute__((target("sse2"))) static inline __m128d exp_sse2(__m128d x)
+{
+    x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(EXP_MIN)), _mm_set1_pd(EXP_MAX));
+
+    __m128i ni = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(EXP_LOG2E)));
+    __m128d n = _mm_cvtepi32_pd(ni);
+    __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(EXP_LN2_HI))),
+                           _mm_mul_pd(n, _mm_set1_pd(EXP_LN2_LO)));
+
+    __m128d p = _mm_set1_pd(EXP_POLY[0]);
+
+    for (int i = 1; i < (int) len(EXP_POLY); i++)
+        p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(EXP_POLY[i]));
+
+    /* 2^n for the two lanes, biased exponent moved into bits 52..62 */
+    __m128i e = _mm_add_epi32(ni, _mm_set1_epi32(1023));
+    e = _mm_slli_epi64(_mm_unpacklo_epi32(e, _mm_setzero_si128()), 52);
+
+    return _mm_mul_pd(p, _mm_castsi128_pd(e));
+}
+
+__attribute__((target("sse2"))) static void propagate_sse2_16(double *e, const double *k, double t)
+{
+    const __m128d vnt = _mm_set1_pd(-t);
+
+    for (int i = 0; i < 16; i += 2)
+        _mm_store_pd(&e[i], exp_sse2(_mm_mul_pd(_mm_load_pd(&k[i]), vnt)));
+}
+
+__attribute__((target("sse2"))) static void segment_const_sse2_16(double *p, const double *e, double pio)
+{
+    const __m128d vpio = _mm_set1_pd(pio);
+    const __m128d one = _mm_set1_pd(1);
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d po = _mm_load_pd(&p[i]);
+        __m128d f = _mm_sub_pd(one, _mm_load_pd(&e[i]));
+
+        _mm_store_pd(&p[i], _mm_add_pd(po, _mm_mul_pd(_mm_sub_pd(vpio, po), f)));
+    }
+}
+
+__attribute__((target("sse2"))) static void segment_ascdec_sse2_16(double *p, const double *e, const double *kinv,
+                                                                   double pio, double r, double t)
+{
+    const __m128d vpio = _mm_set1_pd(pio);
+    const __m128d vr = _mm_set1_pd(r);
+    const __m128d vt = _mm_set1_pd(t);
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d po = _mm_load_pd(&p[i]);
+        __m128d vkinv = _mm_load_pd(&kinv[i]);
+
+        __m128d lin = _mm_add_pd(vpio, _mm_mul_pd(vr, _mm_sub_pd(vt, vkinv)));
+        __m128d dif = _mm_sub_pd(_mm_sub_pd(vpio, po), _mm_mul_pd(vr, vkinv));
+
+        _mm_store_pd(&p[i], _mm_sub_pd(lin, _mm_mul_pd(dif, _mm_load_pd(&e[i]))));
+    }
+}
+
+__attribute__((target("sse2"))) static void decay_const_sse2_16(double *p, const double *e)
+{
+    const __m128d one = _mm_set1_pd(1);
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d po = _mm_load_pd(&p[i]);
+        __m128d f = _mm_sub_pd(one, _mm_load_pd(&e[i]));
+
+        _mm_store_pd(&p[i], _mm_sub_pd(po, _mm_mul_pd(po, f)));
+    }
+}
+
+__attribute__((target("sse2"))) static void decay_ascdec_sse2_16(double *p, const double *e)
+{
+    for (int i = 0; i < 16; i += 2)
+        _mm_store_pd(&p[i], _mm_mul_pd(_mm_load_pd(&p[i]), _mm_load_pd(&e[i])));
+}
+
+static void propagate_sse2(propagator_t *p, const model_t *m, double t)
+{
+    propagate_sse2_16(p->he_e, m->he_k, t);
+    propagate_sse2_16(p->n2_e, m->n2_k, t);
+}
+
+static void segment_const_sse2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_sse2_16(ts->phe, p->he_e, pio_he);
+    segment_const_sse2_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_n2_sse2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_sse2_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_heliox_sse2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_sse2_16(ts->phe, p->he_e, pio_he);
+    decay_const_sse2_16(ts->pn2, p->n2_e);
+}
+
+static void segment_ascdec_sse2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he, double pio_n2,
+                                double r_he, double r_n2, double t)
+{
+    segment_ascdec_sse2_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    segment_ascdec_sse2_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_n2_sse2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                   double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_sse2_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_heliox_sse2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                       double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_sse2_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    decay_ascdec_sse2_16(ts->pn2, p->n2_e);
+}
+
+__attribute__((target("sse2"))) static inline void blend_ab_sse2(const tissues_t *ts, const model_t *m, int i,
+                                                                 __m128d *p, __m128d *a, __m128d *b)
+{
+    __m128d vhe = _mm_load_pd(&ts->phe[i]);
+    __m128d vn2 = _mm_load_pd(&ts->pn2[i]);
+
+    __m128d an = _mm_mul_pd(_mm_load_pd(&m->n2_a[i]), vn2);
+    __m128d ah = _mm_mul_pd(_mm_load_pd(&m->he_a[i]), vhe);
+    __m128d bn = _mm_mul_pd(_mm_load_pd(&m->n2_b[i]), vn2);
+    __m128d bh = _mm_mul_pd(_mm_load_pd(&m->he_b[i]), vhe);
+
+    *p = _mm_add_pd(vn2, vhe);
+    *a = _mm_div_pd(_mm_add_pd(an, ah), *p);
+    *b = _mm_div_pd(_mm_add_pd(bn, bh), *p);
+}
+
+__attribute__((target("sse2"))) static inline double hmax_sse2(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_max_pd(v, _mm_unpackhi_pd(v, v)));
+}
+
+__attribute__((target("sse2"))) static double ceiling_sse2(const tissues_t *ts, const model_t *m, double gf)
+{
+    const __m128d vgf = _mm_set1_pd(gf);
+    const __m128d one = _mm_set1_pd(1);
+
+    __m128d c = _mm_setzero_pd();
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d p, a, b;
+        blend_ab_sse2(ts, m, i, &p, &a, &b);
+
+        __m128d num = _mm_sub_pd(p, _mm_mul_pd(a, vgf));
+        __m128d den = _mm_sub_pd(_mm_add_pd(_mm_div_pd(vgf, b), one), vgf);
+
+        c = _mm_max_pd(c, _mm_div_pd(num, den));
+    }
+
+    return hmax_sse2(c);
+}
+
+__attribute__((target("sse2"))) static double gf99_sse2(const tissues_t *ts, const model_t *m, double depth)
+{
+    const __m128d vd = _mm_set1_pd(depth);
+
+    __m128d gf = _mm_setzero_pd();
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d p, a, b;
+        blend_ab_sse2(ts, m, i, &p, &a, &b);
+
+        __m128d num = _mm_sub_pd(p, vd);
+        __m128d den = _mm_sub_pd(_mm_add_pd(a, _mm_div_pd(vd, b)), vd);
+
+        gf = _mm_max_pd(gf, _mm_div_pd(num, den));
+    }
+
+    return hmax_sse2(gf);
+}
+
+__attribute__((target("sse2"))) static double ceiling_n2_sse2(const tissues_t *ts, const model_t *m, double gf)
+{
+    const __m128d vgf = _mm_set1_pd(gf);
+    const __m128d one = _mm_set1_pd(1);
+
+    __m128d c = _mm_setzero_pd();
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d num = _mm_sub_pd(_mm_load_pd(&ts->pn2[i]), _mm_mul_pd(_mm_load_pd(&m->n2_a[i]), vgf));
+        __m128d den = _mm_sub_pd(_mm_add_pd(_mm_div_pd(vgf, _mm_load_pd(&m->n2_b[i])), one), vgf);
+
+        c = _mm_max_pd(c, _mm_div_pd(num, den));
+    }
+
+    return hmax_sse2(c);
+}
+
+/* ceilings at n gradient factors from the pressures and a and b values of all compartments */
+__attribute__((target("sse2"))) static inline void ceilings_pab_sse2(const __m128d *p, const __m128d *a,
+                                                                     const __m128d *b, const double *gf, int n,
+                                                                     double *c)
+{
+    const __m128d one = _mm_set1_pd(1);
+
+    for (int j = 0; j < n; j++) {
+        const __m128d vgf = _mm_set1_pd(gf[j]);
+
+        __m128d vc = _mm_setzero_pd();
+
+        for (int i = 0; i < 8; i++) {
+            __m128d num = _mm_sub_pd(p[i], _mm_mul_pd(a[i], vgf));
+            __m128d den = _mm_sub_pd(_mm_add_pd(_mm_div_pd(vgf, b[i]), one), vgf);
+
+            vc = _mm_max_pd(vc, _mm_div_pd(num, den));
+        }
+
+        c[j] = hmax_sse2(vc);
+    }
+}
+
+__attribute__((target("sse2"))) static void ceilings_sse2(const tissues_t *ts, const model_t *m, const double *gf,
+                                                          int n, double *c)
+{
+    __m128d p[8], a[8], b[8];
+
+    for (int i = 0; i < 8; i++)
+        blend_ab_sse2(ts, m, 2 * i, &p[i], &a[i], &b[i]);
+
+    ceilings_pab_sse2(p, a, b, gf, n, c);
+}
+
+__attribute__((target("sse2"))) static void ceilings_n2_sse2(const tissues_t *ts, const model_t *m, const double *gf,
+                                                             int n, double *c)
+{
+    __m128d p[8], a[8], b[8];
+
+    for (int i = 0; i < 8; i++) {
+        p[i] = _mm_load_pd(&ts->pn2[2 * i]);
+        a[i] = _mm_load_pd(&m->n2_a[2 * i]);
+        b[i] = _mm_load_pd(&m->n2_b[2 * i]);
+    }
+
+    ceilings_pab_sse2(p, a, b, gf, n, c);
+}
+
+__attribute__((target("sse2"))) static double gf99_n2_sse2(const tissues_t *ts, const model_t *m, double depth)
+{
+    const __m128d vd = _mm_set1_pd(depth);
+
+    __m128d gf = _mm_setzero_pd();
+
+    for (int i = 0; i < 16; i += 2) {
+        __m128d num = _mm_sub_pd(_mm_load_pd(&ts->pn2[i]), vd);
+        __m128d a = _mm_load_pd(&m->n2_a[i]);
+        __m128d den = _mm_sub_pd(_mm_add_pd(a, _mm_div_pd(vd, _mm_load_pd(&m->n2_b[i]))), vd);
+
+        gf = _mm_max_pd(gf, _mm_div_pd(num, den));
+    }
+
+    return hmax_sse2(gf);
+}
+
+__attribute__((target("avx2"))) static inline __m256d exp_avx2(__m256d x)
+{
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_MIN)), _mm256_set1_pd(EXP_MAX));
+
+    __m128i ni = _mm256_cvtpd_epi32(_mm256_mul_pd(x, _mm256_set1_pd(EXP_LOG2E)));
+    __m256d n = _mm256_cvtepi32_pd(ni);
+    __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(EXP_LN2_HI))),
+                              _mm256_mul_pd(n, _mm256_set1_pd(EXP_LN2_LO)));
+
+    __m256d p = _mm256_set1_pd(EXP_POLY[0]);
+
+    for (int i = 1; i < (int) len(EXP_POLY); i++)
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(EXP_POLY[i]));
+
+    /* 2^n for the four lanes, biased exponent moved into bits 52..62 */
+    __m256i e = _mm256_cvtepi32_epi64(_mm_add_epi32(ni, _mm_set1_epi32(1023)));
+    e = _mm256_slli_epi64(e, 52);
+
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+}
+
+__attribute__((target("avx2"))) static void propagate_avx2_16(double *e, const double *k, double t)
+{
+    const __m256d vnt = _mm256_set1_pd(-t);
+
+    for (int i = 0; i < 16; i += 4)
+        _mm256_store_pd(&e[i], exp_avx2(_mm256_mul_pd(_mm256_load_pd(&k[i]), vnt)));
+}
+
+__attribute__((target("avx2"))) static void segment_const_avx2_16(double *p, const double *e, double pio)
+{
+    const __m256d vpio = _mm256_set1_pd(pio);
+    const __m256d one = _mm256_set1_pd(1);
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d po = _mm256_load_pd(&p[i]);
+        __m256d f = _mm256_sub_pd(one, _mm256_load_pd(&e[i]));
+
+        _mm256_store_pd(&p[i], _mm256_add_pd(po, _mm256_mul_pd(_mm256_sub_pd(vpio, po), f)));
+    }
+}
+
+__attribute__((target("avx2"))) static void segment_ascdec_avx2_16(double *p, const double *e, const double *kinv,
+                                                                   double pio, double r, double t)
+{
+    const __m256d vpio = _mm256_set1_pd(pio);
+    const __m256d vr = _mm256_set1_pd(r);
+    const __m256d vt = _mm256_set1_pd(t);
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d po = _mm256_load_pd(&p[i]);
+        __m256d vkinv = _mm256_load_pd(&kinv[i]);
+
+        __m256d lin = _mm256_add_pd(vpio, _mm256_mul_pd(vr, _mm256_sub_pd(vt, vkinv)));
+        __m256d dif = _mm256_sub_pd(_mm256_sub_pd(vpio, po), _mm256_mul_pd(vr, vkinv));
+
+        _mm256_store_pd(&p[i], _mm256_sub_pd(lin, _mm256_mul_pd(dif, _mm256_load_pd(&e[i]))));
+    }
+}
+
+__attribute__((target("avx2"))) static void decay_const_avx2_16(double *p, const double *e)
+{
+    const __m256d one = _mm256_set1_pd(1);
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d po = _mm256_load_pd(&p[i]);
+        __m256d f = _mm256_sub_pd(one, _mm256_load_pd(&e[i]));
+
+        _mm256_store_pd(&p[i], _mm256_sub_pd(po, _mm256_mul_pd(po, f)));
+    }
+}
+
+__attribute__((target("avx2"))) static void decay_ascdec_avx2_16(double *p, const double *e)
+{
+    for (int i = 0; i < 16; i += 4)
+        _mm256_store_pd(&p[i], _mm256_mul_pd(_mm256_load_pd(&p[i]), _mm256_load_pd(&e[i])));
+}
+
+static void propagate_avx2(propagator_t *p, const model_t *m, double t)
+{
+    propagate_avx2_16(p->he_e, m->he_k, t);
+    propagate_avx2_16(p->n2_e, m->n2_k, t);
+}
+
+static void segment_const_avx2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_avx2_16(ts->phe, p->he_e, pio_he);
+    segment_const_avx2_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_n2_avx2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_avx2_16(ts->pn2, p->n2_e, pio_n2);
+}
+
+static void segment_const_heliox_avx2(tissues_t *ts, const propagator_t *p, double pio_he, double pio_n2)
+{
+    segment_const_avx2_16(ts->phe, p->he_e, pio_he);
+    decay_const_avx2_16(ts->pn2, p->n2_e);
+}
+
+static void segment_ascdec_avx2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he, double pio_n2,
+                                double r_he, double r_n2, double t)
+{
+    segment_ascdec_avx2_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    segment_ascdec_avx2_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_n2_avx2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                   double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_avx2_16(ts->pn2, p->n2_e, m->n2_kinv, pio_n2, r_n2, t);
+}
+
+static void segment_ascdec_heliox_avx2(tissues_t *ts, const model_t *m, const propagator_t *p, double pio_he,
+                                       double pio_n2, double r_he, double r_n2, double t)
+{
+    segment_ascdec_avx2_16(ts->phe, p->he_e, m->he_kinv, pio_he, r_he, t);
+    decay_ascdec_avx2_16(ts->pn2, p->n2_e);
+}
+
+__attribute__((target("avx2"))) static inline void blend_ab_avx2(const tissues_t *ts, const model_t *m, int i,
+                                                                 __m256d *p, __m256d *a, __m256d *b)
+{
+    __m256d vhe = _mm256_load_pd(&ts->phe[i]);
+    __m256d vn2 = _mm256_load_pd(&ts->pn2[i]);
+
+    __m256d an = _mm256_mul_pd(_mm256_load_pd(&m->n2_a[i]), vn2);
+    __m256d ah = _mm256_mul_pd(_mm256_load_pd(&m->he_a[i]), vhe);
+    __m256d bn = _mm256_mul_pd(_mm256_load_pd(&m->n2_b[i]), vn2);
+    __m256d bh = _mm256_mul_pd(_mm256_load_pd(&m->he_b[i]), vhe);
+
+    *p = _mm256_add_pd(vn2, vhe);
+    *a = _mm256_div_pd(_mm256_add_pd(an, ah), *p);
+    *b = _mm256_div_pd(_mm256_add_pd(bn, bh), *p);
+}
+
+__attribute__((target("avx2"))) static inline double hmax_avx2(__m256d v)
+{
+    __m128d h = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_max_pd(h, _mm_unpackhi_pd(h, h)));
+}
+
+__attribute__((target("avx2"))) static double ceiling_avx2(const tissues_t *ts, const model_t *m, double gf)
+{
+    const __m256d vgf = _mm256_set1_pd(gf);
+    const __m256d one = _mm256_set1_pd(1);
+
+    __m256d c = _mm256_setzero_pd();
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d p, a, b;
+        blend_ab_avx2(ts, m, i, &p, &a, &b);
+
+        __m256d num = _mm256_sub_pd(p, _mm256_mul_pd(a, vgf));
+        __m256d den = _mm256_sub_pd(_mm256_add_pd(_mm256_div_pd(vgf, b), one), vgf);
+
+        c = _mm256_max_pd(c, _mm256_div_pd(num, den));
+    }
+
+    return hmax_avx2(c);
+}
+
+__attribute__((target("avx2"))) static double gf99_avx2(const tissues_t *ts, const model_t *m, double depth)
+{
+    const __m256d vd = _mm256_set1_pd(depth);
+
+    __m256d gf = _mm256_setzero_pd();
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d p, a, b;
+        blend_ab_avx2(ts, m, i, &p, &a, &b);
+
+        __m256d num = _mm256_sub_pd(p, vd);
+        __m256d den = _mm256_sub_pd(_mm256_add_pd(a, _mm256_div_pd(vd, b)), vd);
+
+        gf = _mm256_max_pd(gf, _mm256_div_pd(num, den));
+    }
+
+    return hmax_avx2(gf);
+}
+
+__attribute__((target("avx2"))) static double ceiling_n2_avx2(const tissues_t *ts, const model_t *m, double gf)
+{
+    const __m256d vgf = _mm256_set1_pd(gf);
+    const __m256d one = _mm256_set1_pd(1);
+
+    __m256d c = _mm256_setzero_pd();
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d num = _mm256_sub_pd(_mm256_load_pd(&ts->pn2[i]), _mm256_mul_pd(_mm256_load_pd(&m->n2_a[i]), vgf));
+        __m256d den = _mm256_sub_pd(_mm256_add_pd(_mm256_div_pd(vgf, _mm256_load_pd(&m->n2_b[i])), one), vgf);
+
+        c = _mm256_max_pd(c, _mm256_div_pd(num, den));
+    }
+
+    return hmax_avx2(c);
+}
+
+__attribute__((target("avx2"))) static inline void ceilings_pab_avx2(const __m256d *p, const __m256d *a,
+                                                                     const __m256d *b, const double *gf, int n,
+                                                                     double *c)
+{
+    const __m256d one = _mm256_set1_pd(1);
+
+    for (int j = 0; j < n; j++) {
+        const __m256d vgf = _mm256_set1_pd(gf[j]);
+
+        __m256d vc = _mm256_setzero_pd();
+
+        for (int i = 0; i < 4; i++) {
+            __m256d num = _mm256_sub_pd(p[i], _mm256_mul_pd(a[i], vgf));
+            __m256d den = _mm256_sub_pd(_mm256_add_pd(_mm256_div_pd(vgf, b[i]), one), vgf);
+
+            vc = _mm256_max_pd(vc, _mm256_div_pd(num, den));
+        }
+
+        c[j] = hmax_avx2(vc);
+    }
+}
+
+__attribute__((target("avx2"))) static void ceilings_avx2(const tissues_t *ts, const model_t *m, const double *gf,
+                                                          int n, double *c)
+{
+    __m256d p[4], a[4], b[4];
+
+    for (int i = 0; i < 4; i++)
+        blend_ab_avx2(ts, m, 4 * i, &p[i], &a[i], &b[i]);
+
+    ceilings_pab_avx2(p, a, b, gf, n, c);
+}
+
+__attribute__((target("avx2"))) static void ceilings_n2_avx2(const tissues_t *ts, const model_t *m, const double *gf,
+                                                             int n, double *c)
+{
+    __m256d p[4], a[4], b[4];
+
+    for (int i = 0; i < 4; i++) {
+        p[i] = _mm256_load_pd(&ts->pn2[4 * i]);
+        a[i] = _mm256_load_pd(&m->n2_a[4 * i]);
+        b[i] = _mm256_load_pd(&m->n2_b[4 * i]);
+    }
+
+    ceilings_pab_avx2(p, a, b, gf, n, c);
+}
+
+__attribute__((target("avx2"))) static double gf99_n2_avx2(const tissues_t *ts, const model_t *m, double depth)
+{
+    const __m256d vd = _mm256_set1_pd(depth);
+
+    __m256d gf = _mm256_setzero_pd();
+
+    for (int i = 0; i < 16; i += 4) {
+        __m256d num = _mm256_sub_pd(_mm256_load_pd(&ts->pn2[i]), vd);
+        __m256d a = _mm256_load_pd(&m->n2_a[i]);
+        __m256d den = _mm256_sub_pd(_mm256_add_pd(a, _mm256_div_pd(vd, _mm256_load_pd(&m->n2_b[i]))), vd);
+
+        gf = _mm256_max_pd(gf, _mm256_div_pd(num, den));
+    }
+
+    return hmax_avx2(gf);
+}
+
+#endif /* KERNEL_X86 */
+
+#define KERNEL_OPS_ENTRY(isa)                                                                                         \
+    {                                                                                                                 \
+        .propagate = &propagate_##isa,                                                                                \
+        .segment_const = {[GAS_TRIMIX] = &segment_const_##isa,                                                        \
+                          [GAS_N2] = &segment_const_n2_##isa,                                                         \
+                          [GAS_HELIOX] = &segment_const_heliox_##isa},                                                \
+        .segment_ascdec = {[GAS_TRIMIX] = &segment_ascdec_##isa,                                                      \
+                           [GAS_N2] = &segment_ascdec_n2_##isa,                                                       \
+                           [GAS_HELIOX] = &segment_ascdec_heliox_##isa},                                              \
+        .ceiling = &ceiling_##isa,                                                                                    \
+        .gf99 = &gf99_##isa,                                                                                          \
+        .ceiling_n2 = &ceiling_n2_##isa,                                                                              \
+        .gf99_n2 = &gf99_n2_##isa,                                                                                    \
+        .ceilings = &ceilings_##isa,                                                                                  \
+        .ceilings_n2 = &ceilings_n2_##isa,                                                                            \
+    }
+
+static const kernel_ops_t KERNEL_OPS[] = {
+    [KERNEL_SCALAR] = KERNEL_OPS_ENTRY(scalar),
+#ifdef KERNEL_X86
+    [KERNEL_SSE2] = KERNEL_OPS_ENTRY(sse2),
+    [KERNEL_AVX2] = KERNEL_OPS_ENTRY(avx2),
+#endif
+};
+
+/* plain statics, written once by kernel_init() and otherwise only by kernel_select() */
+static enum KERNEL active = KERNEL_SCALAR;
+static const kernel_ops_t *active_ops = &KERNEL_OPS[KERNEL_SCALAR];
+static pthread_once_t active_once = PTHREAD_ONCE_INIT;
+
+static int kernel_supported(enum KERNEL kernel)
+{
+    switch (kernel) {
+    case KERNEL_SCALAR:
+        return 1;
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+static enum KERNEL kernel_resolve(enum KERNEL kernel)
+{
+    if (kernel == KERNEL_AUTO) {
+        /* pick the widest kernel the cpu supports */
+        for (kernel = KERNEL_AVX2; !kernel_supported(kernel); kernel--)
+            ;
+    } else if (!kernel_supported(kernel)) {
+        kernel = KERNEL_SCALAR;
+    }
+
+    return kernel;
+}
+
+static void kernel_activate(enum KERNEL kernel)
+{
+    active = kernel;
+    active_ops = &KERNEL_OPS[kernel];
+}
+
+static void kernel_activate_auto(void)
+{
+    kernel_activate(kernel_resolve(KERNEL_AUTO));
+}
+
+/*
+ * Activate the widest kernel the cpu supports, once for the whole process.
+ * model_init() calls this before it computes its propagators, so the kernel
+ * functions that take a model or its tissues dispatch through a plain pointer.
+ */
+void kernel_init(void)
+{
+    pthread_once(&active_once, &kernel_activate_auto);
+}
+
+/*
+ * Switch every thread to kernel, or the widest supported one for KERNEL_AUTO.
+ * Propagators cached by models and plan configs were computed with the exp()
+ * of the previous kernel and are no longer served, see model_propagator().
+ * Meant for tests and benchmarks, before any plan is shared between threads.
+ */
+enum KERNEL kernel_select(enum KERNEL kernel)
+{
+    kernel = kernel_resolve(kernel);
+
+    kernel_init();
+    kernel_activate(kernel);
+
+    return kernel;
+}
+
+/* the kernel in use, the scalar one before kernel_init() */
+enum KERNEL kernel_active(void)
+{
+    return active;
+}
+
+void kernel_propagate(propagator_t *p, const model_t *m, double time)
+{
+    active_ops->propagate(p, m, time);
+
+    p->time = time;
+    p->kernel = active;
+}
+
+/*
+ * Helium is skipped when it is neither inspired nor present in the tissues,
+ * nitrogen only off-gasses when it is not inspired.
+ */
+static enum GAS_CLASS gas_class(const tissues_t *t, double pio_he, double pio_n2, double r_he, double r_n2)
+{
+    if (pio_he == 0 && r_he == 0 && !t->he_loaded)
+        return GAS_N2;
+
+    if (pio_n2 == 0 && r_n2 == 0)
+        return GAS_HELIOX;
+
+    return GAS_TRIMIX;
+}
+
+void kernel_segment_const(tissues_t *t, const propagator_t *p, double pio_he, double pio_n2)
+{
+    active_ops->segment_const[gas_class(t, pio_he, pio_n2, 0, 0)](t, p, pio_he, pio_n2);
+
+    t->he_loaded |= pio_he != 0;
+}
+
+void kernel_segment_ascdec(tissues_t *t, const model_t *m, const propagator_t *p, double pio_he, double pio_n2,
+                           double r_he, double r_n2, double time)
+{
+    enum GAS_CLASS cls = gas_class(t, pio_he, pio_n2, r_he, r_n2);
+
+    active_ops->segment_ascdec[cls](t, m, p, pio_he, pio_n2, r_he, r_n2, time);
+
+    t->he_loaded |= pio_he != 0 || r_he != 0;
+}
+
+double kernel_ceiling(const tissues_t *t, const model_t *m, double gf)
+{
+    if (!t->he_loaded)
+        return active_ops->ceiling_n2(t, m, gf);
+
+    return active_ops->ceiling(t, m, gf);
+}
+
+void kernel_ceilings(const tissues_t *t, const model_t *m, const double *gf, int n, double *c)
+{
+    if (!t->he_loaded)
+        active_ops->ceilings_n2(t, m, gf, n, c);
+    else
+        active_ops->ceilings(t, m, gf, n, c);
+}
+
+double kernel_gf99(const tissues_t *t, const model_t *m, double depth)
+{
+    if (!t->he_loaded)
+        return active_ops->gf99_n2(t, m, depth);
+
+    return active_ops->gf99(t, m, depth);
+}
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "deco.h"
+
+/* types */
+enum KERNEL {
+    KERNEL_AUTO = 0,
+    KERNEL_SCALAR = 1,
+    KERNEL_SSE2 = 2,
+    KERNEL_AVX2 = 3,
+};
+
+/* inert gasses a segment or tissue state involves, selects the kernel variant */
+enum GAS_CLASS {
+    GAS_TRIMIX = 0,
+    GAS_N2 = 1,
+    GAS_HELIOX = 2,
+    GAS_CLASSES,
+};
+
+/* functions */
+void kernel_init(void);
+enum KERNEL kernel_select(enum KERNEL kernel);
+enum KERNEL kernel_active(void);
+
+void kernel_propagate(propagator_t *p, const model_t *m, double time);
+void kernel_segment_const(tissues_t *t, const propagator_t *p, double pio_he, double pio_n2);
+void kernel_segment_ascdec(tissues_t *t, const model_t *m, const propagator_t *p, double pio_he, double pio_n2,
+                           double r_he, double r_n2, double time);
+
+double kernel_ceiling(const tissues_t *t, const model_t *m, double gf);
+void kernel_ceilings(const tissues_t *t, const model_t *m, const double *gf, int n, double *c);
+double kernel_gf99(const tissues_t *t, const model_t *m, double depth);
+
+#endif /* end of include guard: KERNEL_H */
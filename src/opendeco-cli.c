@@ -24,30 +24,55 @@ static char doc[] = "Implementation of Buhlmann ZH-L16 with Gradient Factors:"
                     "\vExamples:\n\n"
                     "  ./opendeco -d 18 -t 60 -g Air\n"
                     "  ./opendeco -d 30 -t 60 -g EAN32\n"
-                    "  ./opendeco -d 40 -t 120 -g 21/35 -L 20 -H 80 --decogasses Oxygen,EAN50\n";
+                    "  ./opendeco -d 40 -t 120 -g 21/35 -L 20 -H 80 --decogasses Oxygen,EAN50\n"
+                    "  ./opendeco -d 45 -t 30 -g 21/35 --decogasses Oxygen,EAN50 --contingency\n"
+                    "  ./opendeco -d 60 -t 25 -g 15/55 --decogasses Oxygen,EAN50,18/45 --bailout\n"
+                    "  ./opendeco -d 39 -t 60 -g EAN32 --table\n"
+                    "  ./opendeco -d 50 -t 30 -g 18/35 --decogasses Oxygen,EAN50 --gfsweep\n"
+                    "  ./opendeco -d 60 -t 20 -g 15/55 -G Oxygen,EAN80,EAN50,EAN32,21/35 --optimize\n"
+                    "  ./opendeco -d 70 -t 20 --decogasses Oxygen,EAN50,21/35 --blend\n"
+                    "  ./opendeco -g EAN32 -L 40 -H 85 --log dive.csv\n"
+                    "  ./opendeco -g EAN32 -H 85 --archive logs/\n"
+                    "  ./opendeco -g EAN32 --log dive.csv --decimate 0.005\n"
+                    "  ./opendeco -g EAN32 --archive logs/ --convert logs.odp\n"
+                    "  ./opendeco -H 85 --profile logs.odp\n";
 const char *argp_program_bug_address = "<~tsegers/opendeco@lists.sr.ht> or https://todo.sr.ht/~tsegers/opendeco";
 const char *argp_program_version = "opendeco " VERSION;
 
 static struct argp_option options[] = {
-    {0,            0,   0,        0,                   "Dive options:",                                                   0 },
-    {"depth",      'd', "NUMBER", 0,                   "Set the depth of the dive in meters",                             0 },
-    {"time",       't', "NUMBER", 0,                   "Set the time of the dive in minutes",                             1 },
-    {"gas",        'g', "STRING", 0,                   "Set the bottom gas used during the dive, defaults to Air",        2 },
-    {"pressure",   'p', "NUMBER", 0,                   "Set the surface air pressure, defaults to 1.01325bar or 1atm",    3 },
-    {"rmv",        'r', "NUMBER", 0,                   "Set the RMV during the dive portion of the dive, defaults to 20", 4 },
-
-    {0,            0,   0,        0,                   "Deco options:",                                                   0 },
-    {"gflow",      'L', "NUMBER", 0,                   "Set the gradient factor at the first stop, defaults to 30",       5 },
-    {"gfhigh",     'H', "NUMBER", 0,                   "Set the gradient factor at the surface, defaults to 75",          6 },
-    {"decogasses", 'G', "LIST",   0,                   "Set the gasses available for deco",                               7 },
-    {0,            'S', 0,        OPTION_ARG_OPTIONAL, "Only switch gas at deco stops",                                   8 },
-    {0,            '6', 0,        OPTION_ARG_OPTIONAL, "Perform last deco stop at 6m",                                    9 },
-    {"decormv",    'R', "NUMBER", 0,                   "Set the RMV during the deco portion of the dive, defaults to 15", 10},
-    {"showtravel", 'T', 0,        0,                   "Show travel segments in deco plan",                               11},
-
-    {0,            0,   0,        0,                   "Informational options:",                                          0 },
-    {"licenses",   -1,  0,        0,                   "Show third-party licenses",                                       0 },
-    {0,            0,   0,        0,                   0,                                                                 0 }
+    {0,             0,   0,        0,                   "Dive options:",                                                   0 },
+    {"depth",       'd', "NUMBER", 0,                   "Set the depth of the dive in meters",                             0 },
+    {"time",        't', "NUMBER", 0,                   "Set the time of the dive in minutes",                             1 },
+    {"gas",         'g', "STRING", 0,                   "Set the bottom gas used during the dive, defaults to Air",        2 },
+    {"pressure",    'p', "NUMBER", 0,                   "Set the surface air pressure, defaults to 1.01325bar or 1atm",    3 },
+    {"rmv",         'r', "NUMBER", 0,                   "Set the RMV during the dive portion of the dive, defaults to 20", 4 },
+
+    {0,             0,   0,        0,                   "Deco options:",                                                   0 },
+    {"gflow",       'L', "NUMBER", 0,                   "Set the gradient factor at the first stop, defaults to 30",       5 },
+    {"gfhigh",      'H', "NUMBER", 0,                   "Set the gradient factor at the surface, defaults to 75",          6 },
+    {"decogasses",  'G', "LIST",   0,                   "Set the gasses available for deco",                               7 },
+    {0,             'S', 0,        OPTION_ARG_OPTIONAL, "Only switch gas at deco stops",                                   8 },
+    {0,             '6', 0,        OPTION_ARG_OPTIONAL, "Perform last deco stop at 6m",                                    9 },
+    {"decormv",     'R', "NUMBER", 0,                   "Set the RMV during the deco portion of the dive, defaults to 15", 10},
+    {"showtravel",  'T', 0,        0,                   "Show travel segments in deco plan",                               11},
+
+    {0,             0,   0,        0,                   "Planning modes:",                                                 0 },
+    {"contingency", 'C', 0,        0,                   "Print a contingency slate instead of the deco plan",              12},
+    {"bailout",     'B', 0,        0,                   "Print a bailout matrix instead of the deco plan",                 13},
+    {"table",       'N', 0,        0,                   "Print a dive table up to the depth and time of the dive",         14},
+    {"gfsweep",     'W', 0,        0,                   "Print the TTS for a grid of gradient factors instead",            15},
+    {"optimize",    'O', "GOAL",   OPTION_ARG_OPTIONAL, "Pick the deco gasses for the least tts or gas, defaults to tts",  16},
+    {"blend",       'M', "GOAL",   OPTION_ARG_OPTIONAL, "Pick the bottom gas for the least tts or gas, defaults to tts",   17},
+    {"log",         'l', "FILE",   0,                   "Replay a time,depth[,gas] CSV dive log, - reads stdin",           18},
+    {"archive",     'A', "PATH",   0,                   "Summarize every log in a directory or in a list of files",        19},
+    {"decimate",    'D', "NUMBER", 0,                   "Merge log samples, keeping tissues within NUMBER bar",            20},
+    {"convert",     'c', "FILE",   0,                   "Convert the logs to a binary profile container instead",          21},
+    {"profile",     'P', "FILE",   0,                   "Summarize every dive in a profile container",                     22},
+    {"threads",     'j', "NUMBER", 0,                   "Set the number of threads, defaults to all cpus",                 23},
+
+    {0,             0,   0,        0,                   "Informational options:",                                          0 },
+    {"licenses",    -1,  0,        0,                   "Show third-party licenses",                                       0 },
+    {0,             0,   0,        0,                   0,                                                                 0 }
 };
 
 static void print_licenses()
@@ -57,6 +82,17 @@ static void print_licenses()
     print_xxd_arr("siu/minunit", minunit_LICENSE);
 }
 
+static enum OPTIMIZE parse_goal(struct argp_state *state, const char *arg)
+{
+    if (!arg || !strcmp(arg, "tts"))
+        return OPTIMIZE_TTS;
+    else if (!strcmp(arg, "gas"))
+        return OPTIMIZE_GAS;
+
+    argp_failure(state, 1, 0, "Optimization goal must be tts or gas");
+    exit(ARGP_ERR_UNKNOWN);
+}
+
 static error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
     struct arguments *arguments = state->input;
@@ -104,11 +140,64 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'T':
         arguments->SHOW_TRAVEL = 1;
         break;
+    case 'C':
+        arguments->CONTINGENCY = 1;
+        break;
+    case 'B':
+        arguments->BAILOUT = 1;
+        break;
+    case 'N':
+        arguments->TABLE = 1;
+        break;
+    case 'W':
+        arguments->GF_SWEEP = 1;
+        break;
+    case 'O':
+        arguments->OPTIMIZE = parse_goal(state, arg);
+        break;
+    case 'M':
+        arguments->BLEND = parse_goal(state, arg);
+        break;
+    case 'l':
+        if (arguments->LOG)
+            free(arguments->LOG);
+
+        arguments->LOG = strdup(arg);
+        break;
+    case 'A':
+        if (arguments->ARCHIVE)
+            free(arguments->ARCHIVE);
+
+        arguments->ARCHIVE = strdup(arg);
+        break;
+    case 'D':
+        arguments->DECIMATE = arg ? atof(arg) : -1;
+        break;
+    case 'c':
+        if (arguments->CONVERT)
+            free(arguments->CONVERT);
+
+        arguments->CONVERT = strdup(arg);
+        break;
+    case 'P':
+        if (arguments->PROFILE)
+            free(arguments->PROFILE);
+
+        arguments->PROFILE = strdup(arg);
+        break;
+    case 'j':
+        arguments->THREADS = arg ? atoi(arg) : -1;
+        break;
     case -1:
         print_licenses();
         exit(ARGP_ERR_UNKNOWN);
     case ARGP_KEY_END:
-        if (arguments->depth < 0 || arguments->time < 0) {
+        if (arguments->CONVERT && !arguments->LOG && !arguments->ARCHIVE) {
+            argp_failure(state, 1, 0, "Option --convert requires --log or --archive");
+            exit(ARGP_ERR_UNKNOWN);
+        }
+        if (!arguments->LOG && !arguments->ARCHIVE && !arguments->PROFILE &&
+            (arguments->depth < 0 || arguments->time < 0)) {
             argp_state_help(state, stderr, ARGP_HELP_USAGE);
             argp_failure(state, 1, 0, "Options -d and -t are required. See --help for more information");
             exit(ARGP_ERR_UNKNOWN);
@@ -137,6 +226,14 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
             argp_failure(state, 1, 0, "Deco RMV must be greater than 0");
             exit(ARGP_ERR_UNKNOWN);
         }
+        if (arguments->DECIMATE < 0) {
+            argp_failure(state, 1, 0, "Decimation tolerance must not be negative");
+            exit(ARGP_ERR_UNKNOWN);
+        }
+        if (arguments->THREADS < 0) {
+            argp_failure(state, 1, 0, "Number of threads must not be negative");
+            exit(ARGP_ERR_UNKNOWN);
+        }
     default:
         return ARGP_ERR_UNKNOWN;
     }
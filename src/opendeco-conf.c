@@ -96,6 +96,11 @@ int opendeco_conf_parse(const char *confpath, struct arguments *arguments)
 
         if (T.ok)
             arguments->SHOW_TRAVEL = T.u.b;
+
+        toml_datum_t j = toml_int_in(conf, "threads");
+
+        if (j.ok)
+            arguments->THREADS = j.u.i;
     }
 
     toml_free(od_conf);
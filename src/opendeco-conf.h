@@ -8,6 +8,12 @@
 #endif
 
 /* types */
+enum OPTIMIZE {
+    OPTIMIZE_NONE,
+    OPTIMIZE_TTS,
+    OPTIMIZE_GAS,
+};
+
 struct arguments {
     double depth;
     double time;
@@ -21,6 +27,18 @@ struct arguments {
     double RMV_DIVE;
     double RMV_DECO;
     int SHOW_TRAVEL;
+    int CONTINGENCY;
+    int BAILOUT;
+    int TABLE;
+    int GF_SWEEP;
+    enum OPTIMIZE OPTIMIZE;
+    enum OPTIMIZE BLEND;
+    int THREADS;
+    char *LOG;
+    char *ARCHIVE;
+    double DECIMATE;
+    char *CONVERT;
+    char *PROFILE;
 };
 
 int opendeco_conf_parse(const char *confpath, struct arguments *arguments);
@@ -2,22 +2,38 @@
 
 #include <locale.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 
+#include "archive.h"
 #include "deco.h"
+#include "divelog.h"
 #include "opendeco-cli.h"
 #include "opendeco-conf.h"
+#include "optimize.h"
 #include "output.h"
+#include "pool.h"
+#include "profile.h"
 #include "schedule.h"
+#include "sweep.h"
+#include "table.h"
 
-#define MOD_OXY (abs_depth(msw_to_bar(6)))
+#define MOD_OXY(ctx) (abs_depth((ctx), msw_to_bar(6)))
 
 #define RMV_DIVE_DEFAULT 20
 #define RMV_DECO_DEFAULT 15
 #define SHOW_TRAVEL_DEFAULT 0
 
+#define TABLE_DEPTH_MIN 9 /* meters */
+#define TABLE_DEPTH_STEP 3
+#define TABLE_TIME_STEP 5 /* minutes */
+
+#define GF_SWEEP_MIN 10
+#define GF_SWEEP_MAX 100
+#define GF_SWEEP_STEP 5
+
 double RMV_DIVE = RMV_DIVE_DEFAULT;
 double RMV_DECO = RMV_DECO_DEFAULT;
 
@@ -68,11 +84,13 @@ void print_segment_callback_fn(const decostate_t *ds, waypoint_t wp, segtype_t t
     static double last_depth;
     static double runtime;
 
+    const opendeco_ctx *ctx = ds->conf->ctx;
+
     wchar_t sign;
 
     /* first time initialization */
     if (!last_depth)
-        last_depth = SURFACE_PRESSURE;
+        last_depth = opendeco_ctx_surface_pressure(ctx);
 
     runtime += wp.time;
 
@@ -84,7 +102,7 @@ void print_segment_callback_fn(const decostate_t *ds, waypoint_t wp, segtype_t t
         sign = LVL;
 
     if (SHOW_TRAVEL || type != SEG_TRAVEL)
-        print_planline(sign, wp.depth, wp.time, runtime, wp.gas);
+        print_planline(ctx, sign, wp.depth, wp.time, runtime, wp.gas);
 
     /* register gas use */
     double avg_seg_depth = wp.depth == last_depth ? last_depth : (wp.depth + last_depth) / 2;
@@ -95,7 +113,7 @@ void print_segment_callback_fn(const decostate_t *ds, waypoint_t wp, segtype_t t
     last_depth = wp.depth;
 }
 
-int parse_gasses(gas_t **gasses, char *str)
+int parse_gasses(const opendeco_ctx *ctx, gas_t **gasses, char *str)
 {
     if (!str) {
         *gasses = NULL;
@@ -125,12 +143,479 @@ int parse_gasses(gas_t **gasses, char *str)
         if (!gas_str)
             break;
 
-        scan_gas(&deco_gasses[gas_idx], gas_str);
+        scan_gas(ctx, &deco_gasses[gas_idx], gas_str);
         gas_idx++;
     }
 
+    /* an empty list has no gasses, only the count above */
     *gasses = deco_gasses;
-    return nof_gasses;
+    return gas_idx;
+}
+
+/* a descent at 9m/min and a stay at depth until the time of the dive */
+static void dive_waypoints(waypoint_t waypoints[2], const opendeco_ctx *ctx, const struct arguments *arguments,
+                           const gas_t *bottom_gas)
+{
+    double dec_per_min = msw_to_bar(9);
+
+    double depth = abs_depth(ctx, msw_to_bar(arguments->depth));
+    double descent_time = msw_to_bar(arguments->depth) / dec_per_min;
+    double bottom_time = max(1, arguments->time - descent_time);
+
+    waypoints[0] = (waypoint_t){.depth = depth, .time = descent_time, .gas = bottom_gas};
+    waypoints[1] = (waypoint_t){.depth = depth, .time = bottom_time, .gas = bottom_gas};
+}
+
+/* simulate the dive phase of dive_waypoints() on ds, returns the depth it ends at */
+static double simulate_dive_phase(decostate_t *ds, const decoconf_t *conf, const struct arguments *arguments,
+                                  const gas_t *bottom_gas, const waypoint_callback_t *wp_cb)
+{
+    waypoint_t waypoints[2];
+    dive_waypoints(waypoints, conf->ctx, arguments, bottom_gas);
+
+    init_decostate(ds, conf);
+    simulate_dive(ds, waypoints, len(waypoints), wp_cb);
+
+    return waypoints[len(waypoints) - 1].depth;
+}
+
+static int out_of_memory(void)
+{
+    fwprintf(stderr, L"Unable to allocate memory\n");
+    return EXIT_FAILURE;
+}
+
+static int print_dive_plan(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                           const gas_t *deco_gasses, int nof_gasses)
+{
+    waypoint_callback_t print_segment_callback = {
+        .fn = &print_segment_callback_fn,
+        .arg = NULL,
+    };
+
+    /* simulate dive */
+    decostate_t ds;
+
+    print_planhead();
+    double depth = simulate_dive_phase(&ds, conf, arguments, bottom_gas, &print_segment_callback);
+
+    /* generate deco schedule */
+    const gas_t *gas = bottom_gas;
+
+    /* determine @+5 TTS */
+    decostate_t ds_ = ds;
+    add_segment_const(&ds_, depth, 5, gas);
+    decoinfo_t di_plus5 = calc_deco(&ds_, depth, gas, deco_gasses, nof_gasses, NULL);
+
+    /* print actual deco schedule */
+    decoinfo_t di = calc_deco(&ds, depth, gas, deco_gasses, nof_gasses, &print_segment_callback);
+
+    if (isinf(di.tts) || isinf(di_plus5.tts)) {
+        fwprintf(stderr, L"A deco stop never clears the ceiling on its gas\n");
+        return EXIT_FAILURE;
+    }
+
+    /* output deco info and disclaimer */
+    print_gas_use();
+    wprintf(L"\nNDL: %i TTS: %i TTS @+5: %i\n", (int) floor(di.ndl), (int) ceil(di.tts), (int) ceil(di_plus5.tts));
+    print_planfoot(&ds);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_contingencies(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                               const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    const opendeco_ctx *ctx = conf->ctx;
+    const double depth = abs_depth(ctx, msw_to_bar(arguments->depth));
+
+    contingency_slate_t slate;
+
+    if (contingency_slate(&slate, conf, depth, arguments->time, bottom_gas, deco_gasses, nof_gasses, pool))
+        return out_of_memory();
+
+    print_slate(ctx, &slate);
+    print_planfoot(&slate.variants[0].ds);
+
+    free_contingency_slate(&slate);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_bailouts(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                          const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    const opendeco_ctx *ctx = conf->ctx;
+    const double depth = abs_depth(ctx, msw_to_bar(arguments->depth));
+
+    bailout_matrix_t matrix;
+
+    if (bailout_matrix(&matrix, conf, depth, arguments->time, bottom_gas, deco_gasses, nof_gasses, pool))
+        return out_of_memory();
+
+    print_bailout_matrix(ctx, &matrix);
+    print_planfoot(&matrix.bailouts[matrix.nof_bailouts - 1].ds);
+
+    free_bailout_matrix(&matrix);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_table(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                       const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    const opendeco_ctx *ctx = conf->ctx;
+
+    /* every depth step the bottom gas allows and every time step up to the dive */
+    double depths[64];
+    double times[64];
+    int nof_depths = 0;
+    int nof_times = 0;
+
+    for (int m = TABLE_DEPTH_MIN; m <= arguments->depth && nof_depths < (int) len(depths); m += TABLE_DEPTH_STEP)
+        if (abs_depth(ctx, msw_to_bar(m)) <= gas_mod(bottom_gas))
+            depths[nof_depths++] = abs_depth(ctx, msw_to_bar(m));
+
+    for (int t = TABLE_TIME_STEP; t <= arguments->time && nof_times < (int) len(times); t += TABLE_TIME_STEP)
+        times[nof_times++] = t;
+
+    if (!nof_depths || !nof_times) {
+        fwprintf(stderr, L"Dive tables start at %im and %imin\n", TABLE_DEPTH_MIN, TABLE_TIME_STEP);
+        return EXIT_FAILURE;
+    }
+
+    dive_table_t table;
+
+    if (dive_table(&table, conf, depths, nof_depths, times, nof_times, bottom_gas, deco_gasses, nof_gasses, pool))
+        return out_of_memory();
+
+    print_dive_table(ctx, &table);
+
+    decostate_t ds;
+    init_decostate(&ds, conf);
+    print_planfoot(&ds);
+
+    free_dive_table(&table);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_gf_sweeps(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                           const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    decostate_t ds;
+    double depth = simulate_dive_phase(&ds, conf, arguments, bottom_gas, NULL);
+
+    int gf[(GF_SWEEP_MAX - GF_SWEEP_MIN) / GF_SWEEP_STEP + 1];
+
+    for (int i = 0; i < (int) len(gf); i++)
+        gf[i] = GF_SWEEP_MIN + i * GF_SWEEP_STEP;
+
+    gf_sweep_t sweep;
+
+    if (gf_sweep(&sweep, &ds, depth, bottom_gas, gf, len(gf), gf, len(gf), deco_gasses, nof_gasses, pool))
+        return out_of_memory();
+
+    print_gf_sweep(conf->ctx, &sweep);
+    print_planfoot(&ds);
+
+    free_gf_sweep(&sweep);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_optimized_gasses(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                                  const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    if (!nof_gasses) {
+        fwprintf(stderr, L"The optimizer picks from the deco gasses, see --decogasses\n");
+        return EXIT_FAILURE;
+    }
+
+    decostate_t ds;
+    double depth = simulate_dive_phase(&ds, conf, arguments, bottom_gas, NULL);
+
+    enum OBJECTIVE objective = arguments->OPTIMIZE == OPTIMIZE_GAS ? OBJECTIVE_GAS : OBJECTIVE_TTS;
+    gas_optimizer_t opt;
+
+    if (optimize_deco_gasses(&opt, &ds, depth, bottom_gas, deco_gasses, nof_gasses, OPTIMIZER_GASSES, objective,
+                             RMV_DECO, pool))
+        return out_of_memory();
+
+    print_gas_optimizer(&opt);
+    print_planfoot(&ds);
+
+    free_gas_optimizer(&opt);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_optimized_blend(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                                 const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    /* the gas of the waypoints is replaced by every blend */
+    waypoint_t waypoints[2];
+    dive_waypoints(waypoints, conf->ctx, arguments, bottom_gas);
+
+    enum OBJECTIVE objective = arguments->BLEND == OPTIMIZE_GAS ? OBJECTIVE_GAS : OBJECTIVE_TTS;
+    blend_optimizer_t opt;
+
+    if (optimize_blend(&opt, conf, waypoints, len(waypoints), deco_gasses, nof_gasses, objective, RMV_DECO, pool))
+        return out_of_memory();
+
+    int ret = EXIT_SUCCESS;
+
+    if (opt.best < 0) {
+        fwprintf(stderr, L"No mix stays within the po2 and end limits at this depth\n");
+        ret = EXIT_FAILURE;
+    } else {
+        print_blend_optimizer(conf->ctx, &opt);
+        print_planfoot(&opt.ds[0]);
+    }
+
+    free_blend_optimizer(&opt);
+
+    return ret;
+}
+
+static void print_log_callback_fn(const decostate_t *ds, const log_sample_t *sample, void *arg)
+{
+    double *max_gf99 = arg;
+    *max_gf99 = max(*max_gf99, sample->gf99);
+
+    print_replayline(ds->conf->ctx, sample);
+}
+
+/* convert the logs in paths into a single profile container, one dive per log */
+static int convert_logs(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                        char *const *paths, int nof_paths)
+{
+    FILE *out = fopen(arguments->CONVERT, "wb");
+
+    if (!out) {
+        fwprintf(stderr, L"Unable to create profile container %s\n", arguments->CONVERT);
+        return EXIT_FAILURE;
+    }
+
+    profile_writer_t w;
+    int ret = profile_writer_open(&w, out, opendeco_ctx_surface_pressure(conf->ctx)) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    long nof_samples = 0;
+    long nof_segments = 0;
+
+    for (int i = 0; i < nof_paths && ret == EXIT_SUCCESS; i++) {
+        FILE *file = strcmp(paths[i], "-") ? fopen(paths[i], "r") : stdin;
+        divelog_t log;
+
+        if (!file || init_divelog(&log, file, conf->ctx, bottom_gas)) {
+            fwprintf(stderr, L"Unable to open dive log %s\n", paths[i]);
+
+            if (file && file != stdin)
+                fclose(file);
+
+            ret = EXIT_FAILURE;
+            break;
+        }
+
+        log.tolerance = arguments->DECIMATE;
+
+        if (convert_log(&w, &log) < 0) {
+            fwprintf(stderr, L"Unable to convert line %i of dive log %s\n", log.line, paths[i]);
+            ret = EXIT_FAILURE;
+        }
+
+        nof_samples += log.nof_samples;
+        nof_segments += log.nof_segments;
+
+        free_divelog(&log);
+
+        if (file != stdin)
+            fclose(file);
+    }
+
+    if (profile_writer_close(&w) && ret == EXIT_SUCCESS) {
+        fwprintf(stderr, L"Unable to write profile container %s\n", arguments->CONVERT);
+        ret = EXIT_FAILURE;
+    }
+
+    fclose(out);
+
+    if (ret == EXIT_SUCCESS)
+        wprintf(L"Converted %i dives, %li samples into %li segments\n", nof_paths, nof_samples, nof_segments);
+
+    return ret;
+}
+
+static int print_log_replay(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                            pool_t *pool)
+{
+    if (arguments->CONVERT)
+        return convert_logs(conf, arguments, bottom_gas, &arguments->LOG, 1);
+
+    FILE *file = strcmp(arguments->LOG, "-") ? fopen(arguments->LOG, "r") : stdin;
+
+    if (!file) {
+        fwprintf(stderr, L"Unable to open dive log %s\n", arguments->LOG);
+        return EXIT_FAILURE;
+    }
+
+    divelog_t log;
+
+    if (init_divelog(&log, file, conf->ctx, bottom_gas)) {
+        if (file != stdin)
+            fclose(file);
+
+        return EXIT_FAILURE;
+    }
+
+    log.tolerance = arguments->DECIMATE;
+
+    decostate_t ds;
+    init_decostate(&ds, conf);
+
+    double max_gf99 = 0;
+
+    log_callback_t print_log_callback = {
+        .fn = &print_log_callback_fn,
+        .arg = &max_gf99,
+    };
+
+    print_replayhead();
+    int nof_samples = replay_log(&ds, &log, &print_log_callback, pool);
+
+    int ret = EXIT_SUCCESS;
+
+    if (nof_samples < 0) {
+        fwprintf(stderr, L"Invalid sample on line %i of dive log %s\n", log.line, arguments->LOG);
+        ret = EXIT_FAILURE;
+    } else {
+        wprintf(L"\nSamples: %i Segments: %i Max GF99: %i%%\n", nof_samples, log.nof_segments,
+                (int) round(max_gf99));
+        print_planfoot(&ds);
+    }
+
+    free_divelog(&log);
+
+    if (file != stdin)
+        fclose(file);
+
+    return ret;
+}
+
+static int print_archive(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                         pool_t *pool)
+{
+    char **paths;
+    int nof_paths = list_archive(&paths, arguments->ARCHIVE);
+
+    if (nof_paths < 0) {
+        fwprintf(stderr, L"Unable to list dive logs in %s\n", arguments->ARCHIVE);
+        return EXIT_FAILURE;
+    }
+
+    if (arguments->CONVERT) {
+        int ret = convert_logs(conf, arguments, bottom_gas, paths, nof_paths);
+        free_archive_list(paths, nof_paths);
+        return ret;
+    }
+
+    log_archive_t archive;
+
+    if (analyze_archive(&archive, conf, bottom_gas, paths, nof_paths, arguments->DECIMATE, pool)) {
+        free_archive_list(paths, nof_paths);
+        return out_of_memory();
+    }
+
+    print_log_archive(conf->ctx, &archive, conf->gfhi);
+
+    decostate_t ds;
+    init_decostate(&ds, conf);
+    print_planfoot(&ds);
+
+    free_log_archive(&archive);
+    free_archive_list(paths, nof_paths);
+
+    return EXIT_SUCCESS;
+}
+
+static int print_profile(const decoconf_t *conf, const struct arguments *arguments, pool_t *pool)
+{
+    profile_file_t pf;
+
+    if (profile_open(&pf, arguments->PROFILE)) {
+        fwprintf(stderr, L"Unable to map profile container %s\n", arguments->PROFILE);
+        return EXIT_FAILURE;
+    }
+
+    /* the depths are absolute pressures, so the surface pressure has to match */
+    if (!profile_surface_matches(&pf, conf->ctx)) {
+        fwprintf(stderr, L"Profile container %s was converted at a surface pressure of %.3fbar, see -p\n",
+                 arguments->PROFILE, pf.surface_pressure);
+        profile_close(&pf);
+        return EXIT_FAILURE;
+    }
+
+    log_archive_t archive;
+
+    if (analyze_profile(&archive, conf, &pf, pool)) {
+        profile_close(&pf);
+        return out_of_memory();
+    }
+
+    print_log_archive(conf->ctx, &archive, conf->gfhi);
+
+    decostate_t ds;
+    init_decostate(&ds, conf);
+    print_planfoot(&ds);
+
+    free_log_archive(&archive);
+    profile_close(&pf);
+
+    return EXIT_SUCCESS;
+}
+
+/* whether the mode main() picks spreads its plans over a pool */
+static int mode_uses_pool(const struct arguments *arguments)
+{
+    if (arguments->CONVERT)
+        return 0;
+
+    return arguments->LOG || arguments->ARCHIVE || arguments->PROFILE || arguments->CONTINGENCY || arguments->BAILOUT ||
+           arguments->TABLE || arguments->GF_SWEEP || arguments->OPTIMIZE || arguments->BLEND;
+}
+
+/* the output of the planning mode arguments select, the dive plan if none */
+static int print_mode(const decoconf_t *conf, const struct arguments *arguments, const gas_t *bottom_gas,
+                      const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    if (arguments->LOG)
+        return print_log_replay(conf, arguments, bottom_gas, pool);
+
+    if (arguments->ARCHIVE)
+        return print_archive(conf, arguments, bottom_gas, pool);
+
+    if (arguments->PROFILE)
+        return print_profile(conf, arguments, pool);
+
+    if (arguments->CONTINGENCY)
+        return print_contingencies(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    if (arguments->BAILOUT)
+        return print_bailouts(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    if (arguments->TABLE)
+        return print_table(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    if (arguments->GF_SWEEP)
+        return print_gf_sweeps(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    if (arguments->OPTIMIZE)
+        return print_optimized_gasses(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    if (arguments->BLEND)
+        return print_optimized_blend(conf, arguments, bottom_gas, deco_gasses, nof_gasses, pool);
+
+    return print_dive_plan(conf, arguments, bottom_gas, deco_gasses, nof_gasses);
 }
 
 int main(int argc, char *argv[])
@@ -160,67 +645,52 @@ int main(int argc, char *argv[])
     opendeco_argp_parse(argc, argv, &arguments);
 
     /* apply global options */
-    SURFACE_PRESSURE = arguments.SURFACE_PRESSURE;
-    SWITCH_INTERMEDIATE = arguments.SWITCH_INTERMEDIATE;
-    LAST_STOP_AT_SIX = arguments.LAST_STOP_AT_SIX;
     RMV_DIVE = arguments.RMV_DIVE;
     RMV_DECO = arguments.RMV_DECO;
     SHOW_TRAVEL = arguments.SHOW_TRAVEL;
 
     /* setup */
-    decostate_t ds;
-    init_decostate(&ds, arguments.gflow, arguments.gfhigh, msw_to_bar(3));
-    double dec_per_min = msw_to_bar(9);
+    opendeco_ctx *ctx = opendeco_ctx_new(ALGO_VER_DEFAULT, P_WV_DEFAULT);
+
+    if (!ctx)
+        return EXIT_FAILURE;
+
+    opendeco_ctx_set_surface_pressure(ctx, arguments.SURFACE_PRESSURE);
+    opendeco_ctx_set_switch_intermediate(ctx, arguments.SWITCH_INTERMEDIATE);
+    opendeco_ctx_set_last_stop_at_six(ctx, arguments.LAST_STOP_AT_SIX);
+
+    decoconf_t conf;
+    init_decoconf(&conf, ctx, arguments.gflow, arguments.gfhigh, msw_to_bar(3));
 
     gas_t bottom_gas;
-    scan_gas(&bottom_gas, arguments.gas);
+    scan_gas(ctx, &bottom_gas, arguments.gas);
 
     gas_t *deco_gasses;
-    int nof_gasses = parse_gasses(&deco_gasses, arguments.decogasses);
+    int nof_gasses = parse_gasses(ctx, &deco_gasses, arguments.decogasses);
 
     /* override oxygen mod */
     for (int i = 0; i < nof_gasses; i++)
         if (gas_o2(&deco_gasses[i]) == 100)
-            deco_gasses[i].mod = MOD_OXY;
-
-    /* simulate dive */
-    double descent_time = msw_to_bar(arguments.depth) / dec_per_min;
-    double bottom_time = max(1, arguments.time - descent_time);
-
-    waypoint_t waypoints[] = {
-        {.depth = abs_depth(msw_to_bar(arguments.depth)), .time = descent_time, &bottom_gas},
-        {.depth = abs_depth(msw_to_bar(arguments.depth)), .time = bottom_time,  &bottom_gas},
-    };
-
-    waypoint_callback_t print_segment_callback = {
-        .fn = &print_segment_callback_fn,
-        .arg = NULL,
-    };
-
-    print_planhead();
-    simulate_dive(&ds, waypoints, len(waypoints), &print_segment_callback);
-
-    /* generate deco schedule */
-    double depth = waypoints[len(waypoints) - 1].depth;
-    const gas_t *gas = waypoints[len(waypoints) - 1].gas;
+            deco_gasses[i].mod = MOD_OXY(ctx);
 
-    /* determine @+5 TTS */
-    decostate_t ds_ = ds;
-    add_segment_const(&ds_, depth, 5, gas);
-    decoinfo_t di_plus5 = calc_deco(&ds_, depth, gas, deco_gasses, nof_gasses, NULL);
+    int ret = EXIT_FAILURE;
+    pool_t *pool = NULL;
 
-    /* print actual deco schedule */
-    decoinfo_t di = calc_deco(&ds, depth, gas, deco_gasses, nof_gasses, &print_segment_callback);
-
-    /* output deco info and disclaimer */
-    print_gas_use();
-    wprintf(L"\nNDL: %i TTS: %i TTS @+5: %i\n", (int) floor(di.ndl), (int) ceil(di.tts), (int) ceil(di_plus5.tts));
-    print_planfoot(&ds);
+    if (mode_uses_pool(&arguments) && !(pool = pool_new(arguments.THREADS)))
+        fwprintf(stderr, L"Unable to start the worker threads\n");
+    else
+        ret = print_mode(&conf, &arguments, &bottom_gas, deco_gasses, nof_gasses, pool);
 
     /* cleanup */
+    pool_free(pool);
     free(deco_gasses);
     free(arguments.gas);
     free(arguments.decogasses);
+    free(arguments.LOG);
+    free(arguments.ARCHIVE);
+    free(arguments.CONVERT);
+    free(arguments.PROFILE);
+    opendeco_ctx_free(ctx);
 
-    return 0;
+    return ret;
 }
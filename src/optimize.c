@@ -0,0 +1,356 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "optimize.h"
+
+typedef struct volume_t {
+    double rmv;
+    double last_depth;
+    double volume;
+} volume_t;
+
+/* the gas used by a segment, as accounted for in the dive plan */
+static void add_volume(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    volume_t *v = arg;
+
+    double avg_seg_depth = wp.depth == v->last_depth ? v->last_depth : (wp.depth + v->last_depth) / 2;
+
+    v->volume += avg_seg_depth * wp.time * v->rmv;
+    v->last_depth = wp.depth;
+}
+
+static void lower_bound(double *bound, double tts)
+{
+    double current;
+    __atomic_load(bound, &current, __ATOMIC_RELAXED);
+
+    while (tts < current && !__atomic_compare_exchange(bound, &current, &tts, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void evaluate_set(void *arg, int i)
+{
+    gas_optimizer_t *opt = arg;
+    gas_set_t *set = &opt->sets[i];
+
+    gas_t gasses[OPTIMIZER_GASSES];
+
+    for (int j = 0; j < set->nof_gasses; j++)
+        gasses[j] = opt->candidates[set->gasses[j]];
+
+    gas_schedule_t schedule;
+    init_gas_schedule(&schedule, opt->ds.conf, gasses, set->nof_gasses);
+
+    volume_t v = {
+        .rmv = opt->rmv,
+        .last_depth = opt->depth,
+    };
+
+    waypoint_callback_t wp_cb = {
+        .fn = &add_volume,
+        .arg = &v,
+    };
+
+    /* the volume of an abandoned ascent is unknown, so only tts can prune */
+    double bound = INFINITY;
+
+    if (opt->objective == OBJECTIVE_TTS)
+        __atomic_load(&opt->bound, &bound, __ATOMIC_RELAXED);
+
+    decostate_t ds = opt->ds;
+
+    set->info = calc_deco_bounded(&ds, opt->depth, opt->gas, &schedule, &wp_cb, bound);
+    set->volume = v.volume;
+    set->pruned = set->info.tts > bound;
+
+    if (!set->pruned)
+        lower_bound(&opt->bound, set->info.tts);
+}
+
+static double cost(const gas_optimizer_t *opt, const gas_set_t *set)
+{
+    return opt->objective == OBJECTIVE_TTS ? set->info.tts : set->volume;
+}
+
+static int binomial(int n, int k)
+{
+    long c = 1;
+
+    for (int i = 0; i < k; i++)
+        c = c * (n - i) / (i + 1);
+
+    return c;
+}
+
+/* the next combination of nof_gasses candidates in lexicographic order, 0 after the last one */
+static int next_set(int *gasses, int nof_gasses, int nof_candidates)
+{
+    int j = nof_gasses - 1;
+
+    while (j >= 0 && gasses[j] == nof_candidates - nof_gasses + j)
+        j--;
+
+    if (j < 0)
+        return 0;
+
+    gasses[j]++;
+
+    for (int k = j + 1; k < nof_gasses; k++)
+        gasses[k] = gasses[k - 1] + 1;
+
+    return 1;
+}
+
+/*
+ * Find the set of up to max_gasses of the candidate deco gasses that gives
+ * the shortest ascent or uses the least deco gas from the end of the dive
+ * phase in ds. The sets are evaluated concurrently on the pool, largest
+ * first, all from the same tissues. When optimizing for tts, an ascent is
+ * abandoned as soon as its tts exceeds that of the best set found so far.
+ * Ties go to the set with the fewest gasses, then to the first one, so the
+ * result does not depend on the order of evaluation. Returns -1 if memory
+ * cannot be allocated.
+ */
+int optimize_deco_gasses(gas_optimizer_t *opt, const decostate_t *ds, double depth, const gas_t *gas,
+                         const gas_t *candidates, int nof_candidates, int max_gasses, enum OBJECTIVE objective,
+                         double rmv, pool_t *pool)
+{
+    max_gasses = min(max(0, min(max_gasses, nof_candidates)), OPTIMIZER_GASSES);
+
+    opt->ds = *ds;
+    opt->depth = depth;
+    opt->gas = gas;
+    opt->candidates = candidates;
+    opt->nof_candidates = nof_candidates;
+    opt->objective = objective;
+    opt->rmv = rmv;
+    opt->bound = INFINITY;
+    opt->nof_sets = 0;
+    opt->best = -1;
+
+    int nof_sets = 0;
+
+    for (int k = 1; k <= max_gasses; k++)
+        nof_sets += binomial(nof_candidates, k);
+
+    opt->sets = malloc(max(1, nof_sets) * sizeof(gas_set_t));
+
+    if (!opt->sets)
+        return -1;
+
+    /* large sets tend to give short ascents and thus tight bounds early on */
+    for (int k = max_gasses; k >= 1; k--) {
+        int gasses[OPTIMIZER_GASSES];
+
+        for (int j = 0; j < k; j++)
+            gasses[j] = j;
+
+        do {
+            gas_set_t *set = &opt->sets[opt->nof_sets++];
+
+            set->nof_gasses = k;
+
+            for (int j = 0; j < k; j++)
+                set->gasses[j] = gasses[j];
+        } while (next_set(gasses, k, nof_candidates));
+    }
+
+    pool_for(pool, opt->nof_sets, &evaluate_set, opt);
+
+    for (int i = 0; i < opt->nof_sets; i++) {
+        const gas_set_t *set = &opt->sets[i];
+
+        if (set->pruned)
+            continue;
+
+        if (opt->best < 0 || cost(opt, set) < cost(opt, &opt->sets[opt->best]) ||
+            (cost(opt, set) == cost(opt, &opt->sets[opt->best]) && set->nof_gasses < opt->sets[opt->best].nof_gasses))
+            opt->best = i;
+    }
+
+    return 0;
+}
+
+void free_gas_optimizer(gas_optimizer_t *opt)
+{
+    free(opt->sets);
+    opt->sets = NULL;
+    opt->nof_sets = 0;
+    opt->best = -1;
+}
+
+/*
+ * The tissues after the dive phase on gas. Inspired pressures, and thus the
+ * tissues, are linear in the fractions of the inert gasses, so they follow
+ * from the dive phase on pure oxygen, nitrogen and helium. Matches
+ * simulate_dive() to within rounding.
+ */
+void blend_decostate(decostate_t *ds, const blend_optimizer_t *opt, const gas_t *gas)
+{
+    const double fn2 = gas_n2(gas) / 100.0;
+    const double fhe = gas_he(gas) / 100.0;
+
+    *ds = opt->ds[0];
+    ds->conf = &opt->conf;
+
+    for (int i = 0; i < 16; i++) {
+        ds->tissues.pn2[i] += fn2 * (opt->ds[1].tissues.pn2[i] - opt->ds[0].tissues.pn2[i]);
+        ds->tissues.phe[i] += fhe * (opt->ds[2].tissues.phe[i] - opt->ds[0].tissues.phe[i]);
+    }
+
+    ds->tissues.he_loaded = gas_he(gas) != 0;
+}
+
+static void evaluate_blend(void *arg, int i)
+{
+    blend_optimizer_t *opt = arg;
+    blend_t *blend = &opt->blends[i];
+
+    volume_t v = {
+        .rmv = opt->rmv,
+        .last_depth = opt->depth,
+    };
+
+    waypoint_callback_t wp_cb = {
+        .fn = &add_volume,
+        .arg = &v,
+    };
+
+    double bound = INFINITY;
+
+    if (opt->objective == OBJECTIVE_TTS)
+        __atomic_load(&opt->bound, &bound, __ATOMIC_RELAXED);
+
+    decostate_t ds;
+    blend_decostate(&ds, opt, &blend->gas);
+
+    blend->info = calc_deco_bounded(&ds, opt->depth, &blend->gas, &opt->schedule, &wp_cb, bound);
+    blend->volume = v.volume;
+    blend->pruned = blend->info.tts > bound;
+
+    if (!blend->pruned)
+        lower_bound(&opt->bound, blend->info.tts);
+}
+
+static double blend_cost(const blend_optimizer_t *opt, const blend_t *blend)
+{
+    return opt->objective == OBJECTIVE_TTS ? blend->info.tts : blend->volume;
+}
+
+/*
+ * Find the bottom gas for the dive phase in waypoints, whose gasses are
+ * ignored, that gives the shortest ascent or uses the least gas during the
+ * ascent on the deco gasses. Every whole percentage of oxygen and helium is
+ * considered. Mixes whose MOD for the po2 and end limits is shallower than
+ * the deepest waypoint are ruled out analytically and never evaluated. The
+ * dive phase is simulated three times and shared by all blends, which are
+ * evaluated concurrently on the pool with the richest in oxygen first. Like
+ * optimize_deco_gasses(), tts pruning and tie breaking towards less helium,
+ * then more oxygen, make the result independent of the order of evaluation.
+ * Returns -1 if there are no waypoints or memory cannot be allocated.
+ */
+int optimize_blend(blend_optimizer_t *opt, const decoconf_t *conf, const waypoint_t *waypoints, int nof_waypoints,
+                   const gas_t *deco_gasses, int nof_gasses, enum OBJECTIVE objective, double rmv, pool_t *pool)
+{
+    if (nof_waypoints <= 0)
+        return -1;
+
+    const opendeco_ctx *ctx = conf->ctx;
+
+    opt->conf = *conf;
+    opt->depth = waypoints[nof_waypoints - 1].depth;
+    opt->objective = objective;
+    opt->rmv = rmv;
+    opt->bound = INFINITY;
+    opt->nof_infeasible = 0;
+    opt->nof_blends = 0;
+    opt->best = -1;
+
+    init_gas_schedule(&opt->schedule, &opt->conf, deco_gasses, nof_gasses);
+
+    /* the dive phase on the three pure gasses */
+    const gas_t pure[] = {
+        gas_new(ctx, 100, 0, MOD_AUTO),
+        gas_new(ctx, 0, 0, MOD_AUTO),
+        gas_new(ctx, 0, 100, MOD_AUTO),
+    };
+
+    waypoint_t *wp = malloc(nof_waypoints * sizeof(waypoint_t));
+
+    if (!wp)
+        return -1;
+
+    double max_depth = 0;
+
+    for (int i = 0; i < nof_waypoints; i++) {
+        wp[i] = waypoints[i];
+        max_depth = max(max_depth, waypoints[i].depth);
+    }
+
+    for (int b = 0; b < (int) len(pure); b++) {
+        for (int i = 0; i < nof_waypoints; i++)
+            wp[i].gas = &pure[b];
+
+        init_decostate(&opt->ds[b], &opt->conf);
+        simulate_dive(&opt->ds[b], wp, nof_waypoints, NULL);
+    }
+
+    free(wp);
+
+    /* po2 limits the oxygen and end the nitrogen and oxygen, which bounds the helium from below */
+    const int o2_max = min(100, floor(100 * opendeco_ctx_po2_max(ctx) / max_depth));
+    const int he_min = max(0, ceil(100 * (1 - opendeco_ctx_end_max(ctx) / max_depth)));
+
+    int nof_blends = 0;
+
+    for (int o2 = 1; o2 <= o2_max; o2++)
+        nof_blends += max(0, 100 - o2 - he_min + 1);
+
+    opt->blends = malloc(max(1, nof_blends) * sizeof(blend_t));
+
+    if (!opt->blends)
+        return -1;
+
+    /* like the largest gas sets, the richest blends are evaluated first */
+    for (int o2 = o2_max; o2 >= 1; o2--) {
+        for (int he = he_min; he <= 100 - o2; he++) {
+            gas_t gas = gas_new(ctx, o2, he, MOD_AUTO);
+
+            /* rounding can put a blend on the edge of either limit */
+            if (gas_mod(&gas) < max_depth)
+                continue;
+
+            opt->blends[opt->nof_blends++].gas = gas;
+        }
+    }
+
+    opt->nof_infeasible = 100 * 101 / 2 - opt->nof_blends;
+
+    pool_for(pool, opt->nof_blends, &evaluate_blend, opt);
+
+    for (int i = 0; i < opt->nof_blends; i++) {
+        const blend_t *blend = &opt->blends[i];
+
+        if (blend->pruned)
+            continue;
+
+        /* blends come by descending oxygen, so ties keep the richest one */
+        if (opt->best < 0 || blend_cost(opt, blend) < blend_cost(opt, &opt->blends[opt->best]) ||
+            (blend_cost(opt, blend) == blend_cost(opt, &opt->blends[opt->best]) &&
+             gas_he(&blend->gas) < gas_he(&opt->blends[opt->best].gas)))
+            opt->best = i;
+    }
+
+    return 0;
+}
+
+void free_blend_optimizer(blend_optimizer_t *opt)
+{
+    free(opt->blends);
+    opt->blends = NULL;
+    opt->nof_blends = 0;
+    opt->best = -1;
+}
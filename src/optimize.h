@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "deco.h"
+#include "pool.h"
+#include "schedule.h"
+
+#define OPTIMIZER_GASSES 3 /* the most deco gasses in a set */
+
+/* types */
+enum OBJECTIVE {
+    OBJECTIVE_TTS,
+    OBJECTIVE_GAS,
+};
+
+typedef struct gas_set_t {
+    int nof_gasses;
+    int gasses[OPTIMIZER_GASSES]; /* indices of the candidates, ascending */
+
+    decoinfo_t info;
+    double volume; /* gas used during the ascent in liters */
+    int pruned;    /* abandoned once its tts exceeded the best set found so far */
+} gas_set_t;
+
+typedef struct gas_optimizer_t {
+    decostate_t ds; /* the tissues at the end of the dive phase */
+    double depth;
+    const gas_t *gas;
+    const gas_t *candidates;
+    int nof_candidates;
+
+    enum OBJECTIVE objective;
+    double rmv;
+    double bound; /* the tts of the best set found so far */
+
+    int nof_sets;
+    gas_set_t *sets;
+    int best; /* index of the best set */
+} gas_optimizer_t;
+
+typedef struct blend_t {
+    gas_t gas;
+
+    decoinfo_t info;
+    double volume; /* gas used during the ascent in liters */
+    int pruned;    /* abandoned once its tts exceeded the best blend found so far */
+} blend_t;
+
+typedef struct blend_optimizer_t {
+    decostate_t ds[3]; /* the dive phase on oxygen, nitrogen and helium */
+    decoconf_t conf;
+    double depth;
+    gas_schedule_t schedule;
+
+    enum OBJECTIVE objective;
+    double rmv;
+    double bound; /* the tts of the best blend found so far */
+
+    int nof_infeasible; /* mixes that exceed the po2 or end limits, never evaluated */
+    int nof_blends;
+    blend_t *blends;
+    int best; /* index of the best blend */
+} blend_optimizer_t;
+
+/* functions */
+int optimize_deco_gasses(gas_optimizer_t *opt, const decostate_t *ds, double depth, const gas_t *gas,
+                         const gas_t *candidates, int nof_candidates, int max_gasses, enum OBJECTIVE objective,
+                         double rmv, pool_t *pool);
+void free_gas_optimizer(gas_optimizer_t *opt);
+
+void blend_decostate(decostate_t *ds, const blend_optimizer_t *opt, const gas_t *gas);
+int optimize_blend(blend_optimizer_t *opt, const decoconf_t *conf, const waypoint_t *waypoints, int nof_waypoints,
+                   const gas_t *deco_gasses, int nof_gasses, enum OBJECTIVE objective, double rmv, pool_t *pool);
+void free_blend_optimizer(blend_optimizer_t *opt);
+
+#endif /* end of include guard: OPTIMIZE_H */
@@ -1,11 +1,21 @@
 /* SPDX-License-Identifier: MIT-0 */
 
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "output.h"
 
+/* tts in whole minutes, or inf if a stop never clears */
+static void print_tts(int width, double tts)
+{
+    if (isinf(tts))
+        wprintf(L"  %*s", width, "inf");
+    else
+        wprintf(L"  %*i", width, (int) ceil(tts));
+}
+
 void format_mm_ss(char *buf, size_t buflen, double time)
 {
     double mm;
@@ -30,16 +40,16 @@ void format_gas(char *buf, size_t buflen, const gas_t *gas)
         snprintf(buf, buflen, "%i/%i", gas_o2(gas), gas_he(gas));
 }
 
-void scan_gas(gas_t *gas, char *str)
+void scan_gas(const opendeco_ctx *ctx, gas_t *gas, char *str)
 {
     int o2 = 0;
     int he = 0;
 
     if (!strcmp(str, "Air")) {
-        *gas = gas_new(21, 0, MOD_AUTO);
+        *gas = gas_new(ctx, 21, 0, MOD_AUTO);
         return;
     } else if (!strcmp(str, "Oxygen")) {
-        *gas = gas_new(100, 0, MOD_AUTO);
+        *gas = gas_new(ctx, 100, 0, MOD_AUTO);
         return;
     } else if (!strncmp(str, "EAN", strlen("EAN"))) {
         sscanf(str, "EAN%i", &o2);
@@ -49,7 +59,7 @@ void scan_gas(gas_t *gas, char *str)
         sscanf(str, "%i/%i", &o2, &he);
     }
 
-    *gas = gas_new(o2, he, MOD_AUTO);
+    *gas = gas_new(ctx, o2, he, MOD_AUTO);
 }
 
 void print_planhead(void)
@@ -59,7 +69,8 @@ void print_planhead(void)
             "EAD");
 }
 
-void print_planline(wchar_t sign, double depth, double time, double runtime, const gas_t *gas)
+void print_planline(const opendeco_ctx *ctx, wchar_t sign, double depth, double time, double runtime,
+                    const gas_t *gas)
 {
     static char gasbuf[11];
     static char runbuf[8];
@@ -69,8 +80,8 @@ void print_planline(wchar_t sign, double depth, double time, double runtime, con
 
     static gas_t last_gas;
 
-    const int depth_m = round(bar_to_msw(gauge_depth(depth)));
-    const int ead_m = round(bar_to_msw(max(0, gauge_depth(ead(depth, gas)))));
+    const int depth_m = round(bar_to_msw(gauge_depth(ctx, depth)));
+    const int ead_m = round(bar_to_msw(max(0, gauge_depth(ctx, ead(depth, gas)))));
 
     wchar_t swi = L' ';
 
@@ -101,27 +112,432 @@ void print_planfoot(const decostate_t *ds)
     char *model;
     char *rq;
 
-    if (ALGO_VER == ZHL_16A)
+    if (ds->conf->model->algo == ZHL_16A)
         model = "ZHL-16A";
-    else if (ALGO_VER == ZHL_16B)
+    else if (ds->conf->model->algo == ZHL_16B)
         model = "ZHL-16B";
-    else if (ALGO_VER == ZHL_16C)
+    else if (ds->conf->model->algo == ZHL_16C)
         model = "ZHL-16C";
     else
         model = "???";
 
-    if (P_WV == P_WV_BUHL)
+    if (ds->conf->model->p_wv == P_WV_BUHL)
         rq = "1.0";
-    else if (P_WV == P_WV_NAVY)
+    else if (ds->conf->model->p_wv == P_WV_NAVY)
         rq = "0.9";
-    else if (P_WV == P_WV_SCHR)
+    else if (ds->conf->model->p_wv == P_WV_SCHR)
         rq = "0.8";
     else
         rq = "???";
 
     wprintf(L"\nDeco model: Buhlmann %s\n", model);
-    wprintf(L"Conservatism: GF %i/%i, Rq = %s\n", ds->gflo, ds->gfhi, rq);
-    wprintf(L"Surface pressure: %4.3fbar\n\n", SURFACE_PRESSURE);
+    wprintf(L"Conservatism: GF %i/%i, Rq = %s\n", ds->conf->gflo, ds->conf->gfhi, rq);
+    wprintf(L"Surface pressure: %4.3fbar\n\n", opendeco_ctx_surface_pressure(ds->conf->ctx));
 
     wprintf(L"WARNING: DIVE PLAN MAY BE INACCURATE AND MAY CONTAIN\nERRORS THAT COULD LEAD TO INJURY OR DEATH.\n");
 }
+
+void print_replayhead(void)
+{
+    wprintf(L"DIVE LOG REPLAY\n\n");
+    wprintf(L"%-7s  %-6s  %-9s  %-4s  %-4s  %-6s  %-4s\n", "Runtime", "Depth", "Gas", "Ceil", "GF99", "SurfGF",
+            "Comp");
+}
+
+void print_replayline(const opendeco_ctx *ctx, const log_sample_t *sample)
+{
+    static char gasbuf[11];
+    static char timbuf[16];
+
+    format_gas(gasbuf, len(gasbuf), sample->gas);
+    format_mm_ss(timbuf, len(timbuf), sample->time);
+
+    const double depth_m = bar_to_msw(gauge_depth(ctx, sample->depth));
+    const int ceil_m = ceil(bar_to_msw(max(0, gauge_depth(ctx, sample->ceiling))));
+
+    wprintf(L"%7s  %5.1fm  %-9s  %3im  %3i%%  %5i%%  %4i\n", timbuf, depth_m, gasbuf, ceil_m,
+            (int) round(sample->gf99), (int) round(sample->surf_gf), sample->compartment + 1);
+}
+
+static void format_variant(char *buf, size_t buflen, const contingency_t *v)
+{
+    static char gasbuf[11];
+
+    switch (v->type) {
+    case CONTINGENCY_PLAN:
+        snprintf(buf, buflen, "Plan");
+        break;
+    case CONTINGENCY_DEEPER_DIVE:
+        snprintf(buf, buflen, "+%im", CONTINGENCY_DEEPER);
+        break;
+    case CONTINGENCY_LONGER_DIVE:
+        snprintf(buf, buflen, "+%imin", CONTINGENCY_LONGER);
+        break;
+    case CONTINGENCY_DEEPER_LONGER_DIVE:
+        snprintf(buf, buflen, "+%im +%imin", CONTINGENCY_DEEPER, CONTINGENCY_LONGER);
+        break;
+    case CONTINGENCY_LOST_GAS:
+        format_gas(gasbuf, len(gasbuf), v->lost_gas);
+        snprintf(buf, buflen, "-%s", gasbuf);
+        break;
+    case CONTINGENCY_HIGHER_GF:
+        snprintf(buf, buflen, "GF %i/%i", v->conf.gflo, v->conf.gfhi);
+        break;
+    }
+}
+
+static int stop_depth_m(const opendeco_ctx *ctx, const waypoint_t *stop)
+{
+    return round(bar_to_msw(gauge_depth(ctx, stop->depth)));
+}
+
+/* the deepest stop of plan that is shallower than below_m, or -1 */
+static int next_plan_stop(const opendeco_ctx *ctx, const decoplan_t *plan, int below_m)
+{
+    int row_m = -1;
+
+    for (int s = 0; s < plan->nof_stops; s++) {
+        int depth_m = stop_depth_m(ctx, &plan->stops[s]);
+
+        if (depth_m < below_m && depth_m > row_m)
+            row_m = depth_m;
+    }
+
+    return row_m;
+}
+
+/* the deepest stop of any variant that is shallower than below_m */
+static int next_slate_row(const opendeco_ctx *ctx, const contingency_slate_t *slate, int below_m)
+{
+    int row_m = -1;
+
+    for (int v = 0; v < slate->nof_variants; v++)
+        row_m = max(row_m, next_plan_stop(ctx, &slate->variants[v].plan, below_m));
+
+    return row_m;
+}
+
+/* the time spent at the stops of plan at depth_m, a gas switch may split a stop */
+static double plan_stop_time(const opendeco_ctx *ctx, const decoplan_t *plan, int depth_m)
+{
+    double time = 0;
+
+    for (int s = 0; s < plan->nof_stops; s++)
+        if (stop_depth_m(ctx, &plan->stops[s]) == depth_m)
+            time += plan->stops[s].time;
+
+    return time;
+}
+
+void print_slate(const opendeco_ctx *ctx, const contingency_slate_t *slate)
+{
+    static char namebuf[12];
+
+    wprintf(L"CONTINGENCY SLATE\n\n");
+    wprintf(L" %-5s", "Depth");
+
+    for (int v = 0; v < slate->nof_variants; v++) {
+        format_variant(namebuf, len(namebuf), &slate->variants[v]);
+        wprintf(L"  %10s", namebuf);
+    }
+
+    wprintf(L"\n");
+
+    /* one row per stop depth of any variant, deepest first */
+    for (int row_m = next_slate_row(ctx, slate, INT_MAX); row_m >= 0; row_m = next_slate_row(ctx, slate, row_m)) {
+        wprintf(L" %4im", row_m);
+
+        for (int v = 0; v < slate->nof_variants; v++) {
+            double time = plan_stop_time(ctx, &slate->variants[v].plan, row_m);
+
+            if (time)
+                wprintf(L"  %10i", (int) ceil(time));
+            else
+                wprintf(L"  %10s", "-");
+        }
+
+        wprintf(L"\n");
+    }
+
+    /* variants without obligation show their remaining no-deco time */
+    int ndl = 0;
+
+    for (int v = 0; v < slate->nof_variants; v++)
+        ndl |= slate->variants[v].plan.info.ndl > 0;
+
+    if (ndl) {
+        wprintf(L" %5s", "NDL");
+
+        for (int v = 0; v < slate->nof_variants; v++) {
+            if (slate->variants[v].plan.info.ndl > 0)
+                wprintf(L"  %10i", (int) floor(slate->variants[v].plan.info.ndl));
+            else
+                wprintf(L"  %10s", "-");
+        }
+
+        wprintf(L"\n");
+    }
+
+    wprintf(L" %5s", "TTS");
+
+    for (int v = 0; v < slate->nof_variants; v++)
+        print_tts(10, slate->variants[v].plan.info.tts);
+
+    wprintf(L"\n");
+}
+
+void print_bailout_matrix(const opendeco_ctx *ctx, const bailout_matrix_t *matrix)
+{
+    int ndl = 0;
+
+    for (int i = 0; i < matrix->nof_bailouts; i++)
+        ndl |= matrix->bailouts[i].plan.info.ndl > 0;
+
+    /* one column per stop depth of any bailout, deepest first */
+    int columns[DECOPLAN_STOPS];
+    int nof_columns = 0;
+
+    for (int col_m = INT_MAX; nof_columns < DECOPLAN_STOPS; nof_columns++) {
+        int next_m = -1;
+
+        for (int i = 0; i < matrix->nof_bailouts; i++)
+            next_m = max(next_m, next_plan_stop(ctx, &matrix->bailouts[i].plan, col_m));
+
+        if (next_m < 0)
+            break;
+
+        columns[nof_columns] = col_m = next_m;
+    }
+
+    wprintf(L"BAILOUT MATRIX\n\n");
+    wprintf(L" %-4s", "Time");
+
+    for (int c = 0; c < nof_columns; c++)
+        wprintf(L"  %3im", columns[c]);
+
+    if (ndl)
+        wprintf(L"  %4s", "NDL");
+
+    wprintf(L"  %4s\n", "TTS");
+
+    /* one row per minute of runtime at which the ascent starts */
+    for (int i = 0; i < matrix->nof_bailouts; i++) {
+        const bailout_t *b = &matrix->bailouts[i];
+
+        wprintf(L" %4i", b->time);
+
+        for (int c = 0; c < nof_columns; c++) {
+            double time = plan_stop_time(ctx, &b->plan, columns[c]);
+
+            if (time)
+                wprintf(L"  %4i", (int) ceil(time));
+            else
+                wprintf(L"  %4s", "-");
+        }
+
+        if (ndl && b->plan.info.ndl > 0)
+            wprintf(L"  %4i", (int) floor(b->plan.info.ndl));
+        else if (ndl)
+            wprintf(L"  %4s", "-");
+
+        print_tts(4, b->plan.info.tts);
+        wprintf(L"\n");
+    }
+}
+
+/* the deepest stop of any plan at depth d of table that is shallower than below_m */
+static int next_table_row(const opendeco_ctx *ctx, const dive_table_t *table, int d, int below_m)
+{
+    int row_m = -1;
+
+    for (int t = 0; t < table->nof_times; t++)
+        row_m = max(row_m, next_plan_stop(ctx, dive_table_plan(table, d, t), below_m));
+
+    return row_m;
+}
+
+void print_dive_table(const opendeco_ctx *ctx, const dive_table_t *table)
+{
+    wprintf(L"DIVE TABLE\n\n");
+    wprintf(L" %-5s  %4s", "Depth", "NDL");
+
+    for (int t = 0; t < table->nof_times; t++)
+        wprintf(L"  %4i", (int) table->times[t]);
+
+    wprintf(L"\n");
+
+    /* the tts of every dive that requires deco, followed by its time at every stop */
+    for (int d = 0; d < table->nof_depths; d++) {
+        wprintf(L" %4im", (int) round(bar_to_msw(gauge_depth(ctx, table->depths[d]))));
+
+        if (isinf(table->ndl[d]))
+            wprintf(L"  >%3i", NDL_MAX);
+        else if (table->ndl[d] > 0)
+            wprintf(L"  %4i", (int) floor(table->ndl[d]));
+        else
+            wprintf(L"  %4s", "-");
+
+        for (int t = 0; t < table->nof_times; t++) {
+            const decoplan_t *plan = dive_table_plan(table, d, t);
+
+            if (plan->nof_stops)
+                print_tts(4, plan->info.tts);
+            else
+                wprintf(L"  %4s", "-");
+        }
+
+        wprintf(L"\n");
+
+        for (int row_m = next_table_row(ctx, table, d, INT_MAX); row_m >= 0;
+             row_m = next_table_row(ctx, table, d, row_m)) {
+            wprintf(L" %5s  %3im", "", row_m);
+
+            for (int t = 0; t < table->nof_times; t++) {
+                double time = plan_stop_time(ctx, dive_table_plan(table, d, t), row_m);
+
+                if (time)
+                    wprintf(L"  %4i", (int) ceil(time));
+                else
+                    wprintf(L"  %4s", "");
+            }
+
+            wprintf(L"\n");
+        }
+    }
+}
+
+void print_gf_sweep(const opendeco_ctx *ctx, const gf_sweep_t *sweep)
+{
+    wprintf(L"GF SWEEP\n\n");
+    wprintf(L" %-5s  %4s", "Lo/Hi", "Stop");
+
+    for (int hi = 0; hi < sweep->nof_gfhi; hi++)
+        wprintf(L"  %4i", sweep->gfhi[hi]);
+
+    wprintf(L"\n");
+
+    /* the tts of every combination after the first stop of its gf low */
+    for (int lo = 0; lo < sweep->nof_gflo; lo++) {
+        const double stop_m = bar_to_msw(gauge_depth(ctx, sweep->firststop[lo]));
+
+        wprintf(L" %5i", sweep->gflo[lo]);
+
+        if (stop_m > 1E-2)
+            wprintf(L"  %3im", (int) round(stop_m));
+        else
+            wprintf(L"  %4s", "-");
+
+        for (int hi = 0; hi < sweep->nof_gfhi; hi++) {
+            const decoinfo_t *info = gf_sweep_info(sweep, lo, hi);
+
+            if (info->tts < 0)
+                wprintf(L"  %4s", ".");
+            else
+                print_tts(4, info->tts);
+        }
+
+        wprintf(L"\n");
+    }
+}
+
+void print_gas_optimizer(const gas_optimizer_t *opt)
+{
+    static char gasbuf[11];
+
+    const gas_set_t *best = &opt->sets[opt->best];
+    int pruned = 0;
+
+    for (int i = 0; i < opt->nof_sets; i++)
+        pruned += opt->sets[i].pruned;
+
+    wprintf(L"DECO GAS OPTIMIZER\n\n");
+    wprintf(L"Deco gasses:");
+
+    for (int j = 0; j < best->nof_gasses; j++) {
+        format_gas(gasbuf, len(gasbuf), &opt->candidates[best->gasses[j]]);
+        wprintf(L"%s %s", j ? "," : "", gasbuf);
+    }
+
+    wprintf(L"\nTTS: %i Ascent gas: %i%lc\n", (int) ceil(best->info.tts), (int) ceil(best->volume), LTR);
+    wprintf(L"\nEvaluated %i sets of %i candidates, %i abandoned early\n", opt->nof_sets, opt->nof_candidates,
+            pruned);
+}
+
+void print_blend_optimizer(const opendeco_ctx *ctx, const blend_optimizer_t *opt)
+{
+    static char gasbuf[11];
+
+    const blend_t *best = &opt->blends[opt->best];
+    int pruned = 0;
+
+    for (int i = 0; i < opt->nof_blends; i++)
+        pruned += opt->blends[i].pruned;
+
+    format_gas(gasbuf, len(gasbuf), &best->gas);
+
+    wprintf(L"BOTTOM GAS OPTIMIZER\n\n");
+    wprintf(L"Bottom gas: %s (MOD %im)\n", gasbuf, (int) floor(bar_to_msw(gauge_depth(ctx, gas_mod(&best->gas)))));
+    wprintf(L"TTS: %i Ascent gas: %i%lc\n", (int) ceil(best->info.tts), (int) ceil(best->volume), LTR);
+    wprintf(L"\nEvaluated %i mixes, %i ruled out by the po2 and end limits, %i abandoned early\n", opt->nof_blends,
+            opt->nof_infeasible, pruned);
+}
+
+void print_log_archive(const opendeco_ctx *ctx, const log_archive_t *archive, int gf_limit)
+{
+    static char timbuf[16];
+    static char namebuf[16];
+
+    int nof_flagged = 0;
+    int nof_failed = 0;
+    long nof_samples = 0;
+    long nof_segments = 0;
+
+    wprintf(L"DIVE LOG ARCHIVE\n\n");
+    wprintf(L" %-1s  %-7s  %-7s  %-6s  %-4s  %-5s  %-6s  %-4s  %s\n", "", "Samples", "Runtime", "Depth", "GF99",
+            "Viol", "SurfGF", "Comp", "Log");
+
+    /* dives above gf_limit are flagged with a ! */
+    for (int i = 0; i < archive->nof_dives; i++) {
+        const dive_summary_t *dive = &archive->dives[i];
+
+        /* dives of a profile container go by their index */
+        const char *name = dive->path;
+
+        if (!name) {
+            snprintf(namebuf, len(namebuf), "#%i", i);
+            name = namebuf;
+        }
+
+        if (dive->status == DIVE_UNREADABLE) {
+            wprintf(L" %-1s  %-52s  %s\n", "?", "unreadable", name);
+            nof_failed++;
+            continue;
+        } else if (dive->status == DIVE_INVALID && !dive->path) {
+            wprintf(L" %-1s  %-52s  %s\n", "?", "invalid segment", name);
+            nof_failed++;
+            continue;
+        } else if (dive->status == DIVE_INVALID) {
+            wprintf(L" %-1s  invalid sample on line %-28i  %s\n", "?", dive->line, name);
+            nof_failed++;
+            continue;
+        }
+
+        const int flagged = dive->max_gf99 > gf_limit;
+        nof_flagged += flagged;
+        nof_samples += dive->nof_samples;
+        nof_segments += dive->nof_segments;
+
+        format_mm_ss(timbuf, len(timbuf), dive->runtime);
+
+        wprintf(L" %-1s  %7i  %7s  %5.1fm  %3i%%  %4.1fm  %5i%%  %4i  %s\n", flagged ? "!" : "", dive->nof_samples,
+                timbuf, bar_to_msw(gauge_depth(ctx, dive->max_depth)), (int) round(dive->max_gf99),
+                bar_to_msw(dive->max_violation), (int) round(dive->surf_gf), dive->compartment + 1, name);
+    }
+
+    wprintf(L"\nDives: %i Above GF %i: %i Unreadable or invalid: %i\n", archive->nof_dives, gf_limit, nof_flagged,
+            nof_failed);
+
+    if (nof_segments && nof_segments < nof_samples)
+        wprintf(L"Decimated %li samples into %li segments (%.1fx)\n", nof_samples, nof_segments,
+                (double) nof_samples / nof_segments);
+}
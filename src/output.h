@@ -5,7 +5,13 @@
 
 #include <wchar.h>
 
+#include "archive.h"
+#include "contingency.h"
 #include "deco.h"
+#include "divelog.h"
+#include "optimize.h"
+#include "sweep.h"
+#include "table.h"
 
 #define ASC 0x2197 /* Unicode North East Arrow */
 #define LVL 0x2192 /* Unicode Rightwards Arrow */
@@ -15,10 +21,22 @@
 
 /* functions */
 void print_planhead(void);
-void print_planline(wchar_t sign, double depth, double time, double runtime, const gas_t *gas);
+void print_planline(const opendeco_ctx *ctx, wchar_t sign, double depth, double time, double runtime,
+                    const gas_t *gas);
 void print_planfoot(const decostate_t *ds);
 
-void scan_gas(gas_t *gas, char *str);
+void print_replayhead(void);
+void print_replayline(const opendeco_ctx *ctx, const log_sample_t *sample);
+void print_log_archive(const opendeco_ctx *ctx, const log_archive_t *archive, int gf_limit);
+
+void print_slate(const opendeco_ctx *ctx, const contingency_slate_t *slate);
+void print_bailout_matrix(const opendeco_ctx *ctx, const bailout_matrix_t *matrix);
+void print_dive_table(const opendeco_ctx *ctx, const dive_table_t *table);
+void print_gf_sweep(const opendeco_ctx *ctx, const gf_sweep_t *sweep);
+void print_gas_optimizer(const gas_optimizer_t *opt);
+void print_blend_optimizer(const opendeco_ctx *ctx, const blend_optimizer_t *opt);
+
+void scan_gas(const opendeco_ctx *ctx, gas_t *gas, char *str);
 void format_gas(char *buf, size_t buflen, const gas_t *gas);
 
 #endif /* end of include guard: OUTPUT_H */
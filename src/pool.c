@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+struct pool_t {
+    int nof_threads; /* including the thread calling pool_for() */
+    pthread_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+
+    /* the job of the current pool_for() call, published under lock */
+    pool_fn fn;
+    void *arg;
+    int n;
+    int next;
+    int active;
+    unsigned generation;
+    int quit;
+};
+
+static void pool_drain(pool_t *pool)
+{
+    for (;;) {
+        int i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+
+        if (i >= pool->n)
+            return;
+
+        pool->fn(pool->arg, i);
+    }
+}
+
+static void *pool_worker(void *arg)
+{
+    pool_t *pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (pool->generation == seen && !pool->quit)
+            pthread_cond_wait(&pool->work, &pool->lock);
+
+        if (pool->quit)
+            break;
+
+        seen = pool->generation;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool_drain(pool);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->done);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static int max_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? n : 1;
+}
+
+/*
+ * A pool of nof_threads threads, or one per online cpu if nof_threads <= 0.
+ * Plans run on it share their opendeco_ctx, which must not be the default one.
+ */
+pool_t *pool_new(int nof_threads)
+{
+    if (nof_threads <= 0)
+        nof_threads = max_threads();
+
+    pool_t *pool = calloc(1, sizeof(pool_t));
+
+    if (!pool)
+        return NULL;
+
+    pool->nof_threads = nof_threads;
+    pool->workers = calloc(nof_threads, sizeof(pthread_t));
+
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    /* the calling thread takes part in every job */
+    for (int t = 0; t < nof_threads - 1; t++) {
+        if (pthread_create(&pool->workers[t], NULL, &pool_worker, pool)) {
+            pool->nof_threads = t + 1;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+void pool_free(pool_t *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int t = 0; t < pool->nof_threads - 1; t++)
+        pthread_join(pool->workers[t], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->workers);
+    free(pool);
+}
+
+int pool_threads(const pool_t *pool)
+{
+    return pool ? pool->nof_threads : 1;
+}
+
+/*
+ * Call fn(arg, i) for every i in [0, n) and return once all calls finished.
+ * Calls run concurrently and in no particular order. A NULL pool runs them
+ * in order on the calling thread. Not reentrant, fn must not use the pool.
+ */
+void pool_for(pool_t *pool, int n, pool_fn fn, void *arg)
+{
+    if (!pool || pool->nof_threads == 1 || n <= 1) {
+        for (int i = 0; i < n; i++)
+            fn(arg, i);
+
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->n = n;
+    pool->next = 0;
+    pool->active = pool->nof_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_drain(pool);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->active)
+        pthread_cond_wait(&pool->done, &pool->lock);
+
+    pthread_mutex_unlock(&pool->lock);
+}
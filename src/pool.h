@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef POOL_H
+#define POOL_H
+
+/* types */
+typedef struct pool_t pool_t;
+
+typedef void (*pool_fn)(void *arg, int i);
+
+/* functions */
+pool_t *pool_new(int nof_threads);
+void pool_free(pool_t *pool);
+
+int pool_threads(const pool_t *pool);
+void pool_for(pool_t *pool, int n, pool_fn fn, void *arg);
+
+#endif /* end of include guard: POOL_H */
@@ -0,0 +1,400 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "profile.h"
+
+void init_gas_table(gas_table_t *t)
+{
+    t->nof_gasses = 0;
+}
+
+/*
+ * The id of gas in t, adding it if no equal gas is interned yet. Equal gasses
+ * share an id, so the pointers gas_table_gas() returns can be compared to
+ * tell gasses apart. Returns -1 if t is full.
+ */
+int gas_table_intern(gas_table_t *t, const gas_t *gas)
+{
+    for (int id = 0; id < t->nof_gasses; id++)
+        if (gas_equal(&t->gasses[id], gas))
+            return id;
+
+    if (t->nof_gasses == GAS_TABLE_GASSES)
+        return -1;
+
+    t->gasses[t->nof_gasses] = *gas;
+
+    return t->nof_gasses++;
+}
+
+const gas_t *gas_table_gas(const gas_table_t *t, unsigned char id)
+{
+    return &t->gasses[id];
+}
+
+/*
+ * Pack waypoints into packed, interning their gasses in t. Depths and times
+ * are rounded to single precision, which is well below a millibar and a
+ * tenth of a second for any dive. Returns -1 if t runs out of ids.
+ */
+int pack_waypoints(packed_waypoint_t *packed, gas_table_t *t, const waypoint_t *waypoints, int nof_waypoints)
+{
+    for (int i = 0; i < nof_waypoints; i++) {
+        int id = gas_table_intern(t, waypoints[i].gas);
+
+        if (id < 0)
+            return -1;
+
+        packed[i] = (packed_waypoint_t){
+            .depth = waypoints[i].depth,
+            .time = waypoints[i].time,
+            .gas = id,
+        };
+    }
+
+    return 0;
+}
+
+waypoint_t unpack_waypoint(const gas_table_t *t, const packed_waypoint_t *packed)
+{
+    return (waypoint_t){
+        .depth = packed->depth,
+        .time = packed->time,
+        .gas = gas_table_gas(t, packed->gas),
+    };
+}
+
+/*
+ * simulate_dive() over packed waypoints, wp_cb receives them unpacked with
+ * gasses from t. A waypoint without time is an instantaneous depth change, as
+ * between the first samples of a log that starts at depth, and adds no segment.
+ */
+void simulate_dive_packed(decostate_t *ds, const gas_table_t *t, const packed_waypoint_t *waypoints,
+                          int nof_waypoints, const waypoint_callback_t *wp_cb)
+{
+    double depth = abs_depth(ds->conf->ctx, 0);
+
+    for (int i = 0; i < nof_waypoints; i++) {
+        const waypoint_t wp = unpack_waypoint(t, &waypoints[i]);
+
+        /* otherwise the same segments as simulate_dive() */
+        if (wp.time > 0) {
+            if (wp.depth != depth)
+                add_segment_ascdec(ds, depth, wp.depth, wp.time, wp.gas);
+            else
+                add_segment_const(ds, wp.depth, wp.time, wp.gas);
+        }
+
+        depth = wp.depth;
+
+        if (wp_cb && wp_cb->fn)
+            wp_cb->fn(ds, wp, SEG_DIVE, wp_cb->arg);
+    }
+}
+
+/* little-endian encoding, independent of the host */
+static void put_u32(unsigned char *buf, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        buf[i] = v >> (8 * i);
+}
+
+static void put_u64(unsigned char *buf, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        buf[i] = v >> (8 * i);
+}
+
+static void put_f32(unsigned char *buf, float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    put_u32(buf, v);
+}
+
+static uint32_t get_u32(const unsigned char *buf)
+{
+    uint32_t v = 0;
+
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t) buf[i] << (8 * i);
+
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char *buf)
+{
+    uint64_t v = 0;
+
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) buf[i] << (8 * i);
+
+    return v;
+}
+
+static float get_f32(const unsigned char *buf)
+{
+    uint32_t v = get_u32(buf);
+    float f;
+
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+/* packed waypoints are little-endian in the container and used in place */
+static int host_compatible(void)
+{
+    const uint32_t one = 1;
+
+    return *(const unsigned char *) &one == 1 && sizeof(packed_waypoint_t) == 9;
+}
+
+static int write_header(profile_writer_t *w, uint64_t tables)
+{
+    unsigned char header[PROFILE_HEADER] = {0};
+
+    memcpy(header, PROFILE_MAGIC, 8);
+    put_u32(header + 8, PROFILE_VERSION);
+    put_u32(header + 12, w->gasses.nof_gasses);
+    put_u32(header + 16, w->nof_dives);
+    put_f32(header + 20, w->surface_pressure);
+    put_u64(header + 24, tables);
+
+    if (fseek(w->file, 0, SEEK_SET) || fwrite(header, sizeof(header), 1, w->file) != 1)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Write a profile container to file, which must be seekable. It consists of
+ *
+ *   a header of PROFILE_HEADER bytes: the magic, the version, the number of
+ *     gasses and dives as uint32, the surface pressure as float and the
+ *     offset of the tables as uint64,
+ *   the segments of every dive as packed_waypoint_t, one dive after the other,
+ *   the gas table, one PROFILE_GAS_RECORD per id,
+ *   the dive index, one PROFILE_DIVE_RECORD per dive,
+ *
+ * all little-endian. The tables follow the segments so that dives can be
+ * streamed in, only the index is kept in memory. Depths are absolute
+ * pressures at surface_pressure. Returns -1 if file cannot be written.
+ */
+int profile_writer_open(profile_writer_t *w, FILE *file, double surface_pressure)
+{
+    *w = (profile_writer_t){
+        .file = file,
+        .surface_pressure = surface_pressure,
+        .offset = PROFILE_HEADER,
+    };
+
+    init_gas_table(&w->gasses);
+
+    /* a placeholder until the tables are known */
+    return write_header(w, 0);
+}
+
+/* start the next dive, the waypoints added next start at the surface */
+int profile_writer_dive(profile_writer_t *w)
+{
+    if (w->nof_dives == w->size) {
+        int size = max(64, 2 * w->size);
+        uint64_t *dives = realloc(w->dives, size * 2 * sizeof(uint64_t));
+
+        if (!dives)
+            return -1;
+
+        w->dives = dives;
+        w->size = size;
+    }
+
+    w->dives[2 * w->nof_dives] = w->offset;
+    w->dives[2 * w->nof_dives + 1] = 0;
+    w->nof_dives++;
+
+    return 0;
+}
+
+/* append wp to the current dive, returns -1 if the gas table is full or file cannot be written */
+int profile_writer_add(profile_writer_t *w, const waypoint_t *wp)
+{
+    if (!w->nof_dives)
+        return -1;
+
+    int id = gas_table_intern(&w->gasses, wp->gas);
+
+    if (id < 0)
+        return -1;
+
+    unsigned char buf[sizeof(packed_waypoint_t)];
+
+    put_f32(buf + offsetof(packed_waypoint_t, depth), wp->depth);
+    put_f32(buf + offsetof(packed_waypoint_t, time), wp->time);
+    buf[offsetof(packed_waypoint_t, gas)] = id;
+
+    if (fwrite(buf, sizeof(buf), 1, w->file) != 1)
+        return -1;
+
+    w->offset += sizeof(buf);
+    w->dives[2 * w->nof_dives - 1]++;
+
+    return 0;
+}
+
+/* write the tables and the final header, returns -1 if file cannot be written */
+int profile_writer_close(profile_writer_t *w)
+{
+    const uint64_t tables = w->offset;
+    int ret = 0;
+
+    for (int id = 0; id < w->gasses.nof_gasses && !ret; id++) {
+        const gas_t *gas = gas_table_gas(&w->gasses, id);
+        unsigned char buf[PROFILE_GAS_RECORD] = {gas_o2(gas), gas_he(gas)};
+
+        put_f32(buf + 4, gas_mod(gas));
+        ret = fwrite(buf, sizeof(buf), 1, w->file) != 1;
+    }
+
+    for (int i = 0; i < w->nof_dives && !ret; i++) {
+        unsigned char buf[PROFILE_DIVE_RECORD];
+
+        put_u64(buf, w->dives[2 * i]);
+        put_u64(buf + 8, w->dives[2 * i + 1]);
+        ret = fwrite(buf, sizeof(buf), 1, w->file) != 1;
+    }
+
+    if (!ret)
+        ret = write_header(w, tables);
+
+    if (!ret)
+        ret = fflush(w->file);
+
+    free(w->dives);
+    w->dives = NULL;
+
+    return ret ? -1 : 0;
+}
+
+/*
+ * Map the profile container at path. Only the header and gas table are read,
+ * the dives are paged in as they are replayed, profile_dive() checks their
+ * segments. Returns -1 if path cannot be mapped,
+ * is not a container of PROFILE_VERSION or the host is not little-endian.
+ */
+int profile_open(profile_file_t *pf, const char *path)
+{
+    *pf = (profile_file_t){0};
+
+    if (!host_compatible())
+        return -1;
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+
+    if (fstat(fd, &st) || st.st_size < PROFILE_HEADER) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return -1;
+
+    pf->map = map;
+    pf->size = st.st_size;
+
+    const unsigned char *header = pf->map;
+
+    const uint32_t nof_gasses = get_u32(header + 12);
+    const uint32_t nof_dives = get_u32(header + 16);
+    const uint64_t tables = get_u64(header + 24);
+
+    if (memcmp(header, PROFILE_MAGIC, 8) || get_u32(header + 8) != PROFILE_VERSION ||
+        nof_gasses > GAS_TABLE_GASSES || nof_dives > INT32_MAX || tables < PROFILE_HEADER || tables > pf->size ||
+        (pf->size - tables) / PROFILE_DIVE_RECORD < nof_dives ||
+        pf->size - tables - (uint64_t) nof_dives * PROFILE_DIVE_RECORD != (uint64_t) nof_gasses * PROFILE_GAS_RECORD) {
+        profile_close(pf);
+        return -1;
+    }
+
+    pf->surface_pressure = get_f32(header + 20);
+    pf->nof_dives = nof_dives;
+    pf->index = pf->map + tables + nof_gasses * PROFILE_GAS_RECORD;
+
+    memset(&pf->gasses, 0, sizeof(pf->gasses));
+    pf->gasses.nof_gasses = nof_gasses;
+
+    for (uint32_t id = 0; id < nof_gasses; id++) {
+        const unsigned char *rec = pf->map + tables + id * PROFILE_GAS_RECORD;
+
+        if (rec[0] + rec[1] > 100) {
+            profile_close(pf);
+            return -1;
+        }
+
+        pf->gasses.gasses[id] = gas_new(NULL, rec[0], rec[1], get_f32(rec + 4));
+    }
+
+    return 0;
+}
+
+void profile_close(profile_file_t *pf)
+{
+    if (pf->map)
+        munmap((void *) pf->map, pf->size);
+
+    pf->map = NULL;
+    pf->size = 0;
+    pf->nof_dives = 0;
+}
+
+/* whether the depths of pf are absolute at the surface pressure of ctx, which pf only keeps as a float */
+int profile_surface_matches(const profile_file_t *pf, const opendeco_ctx *ctx)
+{
+    return (float) opendeco_ctx_surface_pressure(ctx) == (float) pf->surface_pressure;
+}
+
+/*
+ * The segments of dive in the mapping of pf, ready for simulate_dive_packed()
+ * with pf->gasses. Returns their number, -1 if dive does not exist or its
+ * segments are outside the container and -2 if a segment has a gas id beyond
+ * the gas table or a depth or time that is negative or not finite.
+ */
+int profile_dive(const profile_file_t *pf, int dive, const packed_waypoint_t **waypoints)
+{
+    if (dive < 0 || dive >= pf->nof_dives)
+        return -1;
+
+    const unsigned char *rec = pf->index + (size_t) dive * PROFILE_DIVE_RECORD;
+    const uint64_t offset = get_u64(rec);
+    const uint64_t n = get_u64(rec + 8);
+    const uint64_t tables = get_u64(pf->map + 24);
+
+    if (offset < PROFILE_HEADER || offset > tables || (tables - offset) / sizeof(packed_waypoint_t) < n ||
+        n > INT32_MAX)
+        return -1;
+
+    const packed_waypoint_t *wp = (const packed_waypoint_t *) (pf->map + offset);
+
+    for (uint64_t i = 0; i < n; i++)
+        if (wp[i].gas >= pf->gasses.nof_gasses || !isfinite(wp[i].depth) || wp[i].depth < 0 ||
+            !isfinite(wp[i].time) || wp[i].time < 0)
+            return -2;
+
+    *waypoints = wp;
+
+    return n;
+}
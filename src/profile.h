@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "deco.h"
+#include "schedule.h"
+
+#define GAS_TABLE_GASSES 256 /* every id a packed waypoint can hold */
+
+#define PROFILE_MAGIC "ODPROFIL"
+#define PROFILE_VERSION 1
+#define PROFILE_HEADER 32      /* bytes, the segments of the first dive follow */
+#define PROFILE_GAS_RECORD 8   /* o2, he, two bytes padding and the mod as float */
+#define PROFILE_DIVE_RECORD 16 /* offset and number of segments as uint64 */
+
+/* types */
+typedef struct gas_table_t {
+    int nof_gasses;
+    gas_t gasses[GAS_TABLE_GASSES]; /* by id, never moved once interned */
+} gas_table_t;
+
+/* a waypoint_t in 9 instead of 24 bytes, its gas is an id into a gas_table_t */
+typedef struct packed_waypoint_t {
+    float depth; /* absolute pressure */
+    float time;  /* minutes */
+    unsigned char gas;
+} __attribute__((packed)) packed_waypoint_t;
+
+/*
+ * A read-only mapping of a profile container, see profile_writer_open() for
+ * the layout. The segments of every dive are used in place.
+ */
+typedef struct profile_file_t {
+    const unsigned char *map;
+    size_t size;
+
+    double surface_pressure; /* the depths were converted at */
+    gas_table_t gasses;
+    int nof_dives;
+    const unsigned char *index;
+} profile_file_t;
+
+typedef struct profile_writer_t {
+    FILE *file;
+    double surface_pressure;
+    gas_table_t gasses;
+
+    uint64_t offset; /* of the next segment */
+    int nof_dives;
+    int size;
+    uint64_t *dives; /* offset and number of segments of every dive */
+} profile_writer_t;
+
+/* functions */
+void init_gas_table(gas_table_t *t);
+int gas_table_intern(gas_table_t *t, const gas_t *gas);
+const gas_t *gas_table_gas(const gas_table_t *t, unsigned char id);
+
+int pack_waypoints(packed_waypoint_t *packed, gas_table_t *t, const waypoint_t *waypoints, int nof_waypoints);
+waypoint_t unpack_waypoint(const gas_table_t *t, const packed_waypoint_t *packed);
+
+void simulate_dive_packed(decostate_t *ds, const gas_table_t *t, const packed_waypoint_t *waypoints,
+                          int nof_waypoints, const waypoint_callback_t *wp_cb);
+
+int profile_writer_open(profile_writer_t *w, FILE *file, double surface_pressure);
+int profile_writer_dive(profile_writer_t *w);
+int profile_writer_add(profile_writer_t *w, const waypoint_t *wp);
+int profile_writer_close(profile_writer_t *w);
+
+int profile_open(profile_file_t *pf, const char *path);
+void profile_close(profile_file_t *pf);
+int profile_dive(const profile_file_t *pf, int dive, const packed_waypoint_t **waypoints);
+int profile_surface_matches(const profile_file_t *pf, const opendeco_ctx *ctx);
+
+#endif /* end of include guard: PROFILE_H */
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <stdlib.h>
+
+#include "replay.h"
+
+/* waypoints below which a chunk is not worth a thread */
+#define REPLAY_CHUNK_MIN 256
+#define REPLAY_CHUNKS_PER_THREAD 4
+
+typedef struct replay_t {
+    double depth; /* before the first waypoint */
+    const waypoint_t *waypoints;
+    int nof_waypoints;
+    int nof_chunks;
+    replay_sample_t *samples;
+
+    segment_op_t *ops;  /* the composed segments of every chunk */
+    decostate_t *state; /* the state at the start of every chunk, at its end once replayed */
+} replay_t;
+
+static int chunk_start(const replay_t *r, int c)
+{
+    return (int) ((long) r->nof_waypoints * c / r->nof_chunks);
+}
+
+/* the depth simulate_dive() ascends or descends from to reach waypoint i */
+static double start_depth(const replay_t *r, int i)
+{
+    return i ? r->waypoints[i - 1].depth : r->depth;
+}
+
+static void replay_compose(void *arg, int c)
+{
+    replay_t *r = arg;
+    const model_t *m = r->state[0].conf->model;
+
+    segment_op_identity(&r->ops[c]);
+
+    for (int i = chunk_start(r, c); i < chunk_start(r, c + 1); i++) {
+        if (r->waypoints[i].time <= 0)
+            continue;
+
+        segment_op_t op;
+        segment_op_waypoint(&op, m, start_depth(r, i), &r->waypoints[i]);
+        segment_op_compose(&r->ops[c], &r->ops[c], &op);
+    }
+}
+
+static void replay_chunk(void *arg, int c)
+{
+    replay_t *r = arg;
+    decostate_t *ds = &r->state[c];
+    const double surface = abs_depth(ds->conf->ctx, 0);
+
+    for (int i = chunk_start(r, c); i < chunk_start(r, c + 1); i++) {
+        const waypoint_t *wp = &r->waypoints[i];
+        const double depth = start_depth(r, i);
+
+        /* same segments as simulate_dive(), a waypoint without time only jumps */
+        if (wp->time > 0 && wp->depth != depth)
+            add_segment_ascdec(ds, depth, wp->depth, wp->time, wp->gas);
+        else if (wp->time > 0)
+            add_segment_const(ds, wp->depth, wp->time, wp->gas);
+
+        replay_sample_t *s = &r->samples[i];
+
+        for (int j = 0; j < 16; j++) {
+            s->phe[j] = ds->tissues.phe[j];
+            s->pn2[j] = ds->tissues.pn2[j];
+        }
+
+        s->ceiling = ceiling(ds, ds->conf->gfhi);
+        s->gf99 = gf99(ds, wp->depth);
+        s->surf_gf = gf99(ds, surface);
+        s->compartment = controlling_compartment(ds, ds->conf->gfhi);
+        s->he_loaded = ds->tissues.he_loaded;
+    }
+}
+
+/*
+ * Replay the waypoints like simulate_dive(), starting at depth instead of the
+ * surface, and record the tissues, ceiling, gf99 at the waypoint and at the
+ * surface and the controlling compartment after every waypoint. A waypoint
+ * without time is an instantaneous depth change like in replay_log(). The
+ * waypoints are split into chunks whose segments are composed into a single
+ * operator in parallel. An exclusive scan over those operators yields the
+ * state at the start of every chunk, after which all chunks are replayed in
+ * parallel. The scan itself is a sequential pass over a few operators per
+ * thread. Chunks other than the first start from a state that only matches
+ * simulate_dive() to within rounding. Returns -1 if memory for the chunks
+ * cannot be allocated.
+ */
+int replay_dive_from(decostate_t *ds, double depth, const waypoint_t *waypoints, int nof_waypoints,
+                     replay_sample_t *samples, pool_t *pool)
+{
+    if (nof_waypoints <= 0)
+        return 0;
+
+    replay_t r = {
+        .depth = depth,
+        .waypoints = waypoints,
+        .nof_waypoints = nof_waypoints,
+        .nof_chunks = min(nof_waypoints / REPLAY_CHUNK_MIN, pool_threads(pool) * REPLAY_CHUNKS_PER_THREAD),
+        .samples = samples,
+    };
+
+    if (r.nof_chunks < 2 || pool_threads(pool) == 1)
+        r.nof_chunks = 1;
+
+    void *mem;
+
+    if (posix_memalign(&mem, 64, r.nof_chunks * (sizeof(segment_op_t) + sizeof(decostate_t))))
+        return -1;
+
+    r.ops = mem;
+    r.state = (decostate_t *) (r.ops + r.nof_chunks);
+    r.state[0] = *ds;
+
+    if (r.nof_chunks > 1) {
+        pool_for(pool, r.nof_chunks - 1, &replay_compose, &r);
+
+        for (int c = 1; c < r.nof_chunks; c++) {
+            r.state[c] = r.state[c - 1];
+            apply_segment_op(&r.state[c], &r.ops[c - 1]);
+        }
+    }
+
+    pool_for(pool, r.nof_chunks, &replay_chunk, &r);
+
+    *ds = r.state[r.nof_chunks - 1];
+
+    free(mem);
+
+    return 0;
+}
+
+/* replay_dive_from() the surface */
+int replay_dive(decostate_t *ds, const waypoint_t *waypoints, int nof_waypoints, replay_sample_t *samples,
+                pool_t *pool)
+{
+    return replay_dive_from(ds, abs_depth(ds->conf->ctx, 0), waypoints, nof_waypoints, samples, pool);
+}
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "deco.h"
+#include "pool.h"
+#include "schedule.h"
+
+/* types */
+typedef struct replay_sample_t {
+    double phe[16];
+    double pn2[16];
+    double ceiling; /* at gfhi */
+    double gf99;
+    double surf_gf;
+    int compartment; /* that controls the ceiling, numbered from 0 */
+    int he_loaded;
+} replay_sample_t;
+
+/* functions */
+int replay_dive_from(decostate_t *ds, double depth, const waypoint_t *waypoints, int nof_waypoints,
+                     replay_sample_t *samples, pool_t *pool);
+int replay_dive(decostate_t *ds, const waypoint_t *waypoints, int nof_waypoints, replay_sample_t *samples,
+                pool_t *pool);
+
+#endif /* end of include guard: REPLAY_H */
@@ -8,8 +8,6 @@
 #define STOPLEN_ROUGH 10
 #define STOPLEN_FINE 1
 
-int SWITCH_INTERMEDIATE = SWITCH_INTERMEDIATE_DEFAULT;
-
 const gas_t *best_gas(double depth, const gas_t *gasses, int nof_gasses)
 {
     const gas_t *best = NULL;
@@ -27,19 +25,158 @@ const gas_t *best_gas(double depth, const gas_t *gasses, int nof_gasses)
     return best;
 }
 
+/* whether best_gas() considers sorted gas i breathable at depth */
+static int schedule_eligible(const gas_schedule_t *s, int i, double depth)
+{
+    return depth - s->mod[i] < 1E-2;
+}
+
+/* index of the first eligible gas, the suffix of eligible gasses starts there */
+static int schedule_search(const gas_schedule_t *s, double depth)
+{
+    int i = 0;
+
+    while (i < s->nof_gasses && !schedule_eligible(s, i, depth))
+        i++;
+
+    return i;
+}
+
+/*
+ * Sort the gasses by mod and resolve best_gas() at every stop of conf from the
+ * surface down to the deepest mod. Schedules with more than GAS_SCHEDULE_GASSES
+ * gasses fall back to best_gas().
+ */
+void init_gas_schedule(gas_schedule_t *s, const decoconf_t *conf, const gas_t *gasses, int nof_gasses)
+{
+    s->gasses = gasses;
+    s->nof_gasses = nof_gasses;
+    s->surface = abs_depth(conf->ctx, 0);
+    s->ceil_multiple = conf->ceil_multiple;
+    s->nof_stops = 0;
+
+    if (nof_gasses > GAS_SCHEDULE_GASSES)
+        return;
+
+    /* insertion sort keeps the first of equal mods first, like best_gas() */
+    for (int i = 0; i < nof_gasses; i++) {
+        double mod = gas_mod(&gasses[i]);
+        int j = i;
+
+        for (; j > 0 && s->mod[j - 1] > mod; j--) {
+            s->sorted[j] = s->sorted[j - 1];
+            s->mod[j] = s->mod[j - 1];
+        }
+
+        s->sorted[j] = &gasses[i];
+        s->mod[j] = mod;
+    }
+
+    if (!nof_gasses || s->ceil_multiple <= 0)
+        return;
+
+    const double deepest = s->mod[nof_gasses - 1] - s->surface;
+    s->nof_stops = min(GAS_SCHEDULE_STOPS, (int) max(0, ceil(deepest / s->ceil_multiple)) + 2);
+
+    for (int k = 0; k < s->nof_stops; k++)
+        s->stop_gas[k] = schedule_search(s, s->surface + k * s->ceil_multiple);
+}
+
+/*
+ * Same result as best_gas() on the gasses of the schedule. Depths near a stop
+ * take the gas of that stop, which only needs checking against its neighbour
+ * in the sorted gasses since the eligible ones form a suffix.
+ */
+const gas_t *gas_schedule_best(const gas_schedule_t *s, double depth)
+{
+    if (s->nof_gasses > GAS_SCHEDULE_GASSES)
+        return best_gas(depth, s->gasses, s->nof_gasses);
+
+    /* the stop nearest to depth */
+    const double k = s->nof_stops ? floor((depth - s->surface) / s->ceil_multiple + 0.5) : -1;
+
+    if (k >= 0 && k < s->nof_stops) {
+        const int i = s->stop_gas[(int) k];
+
+        if ((i == s->nof_gasses || schedule_eligible(s, i, depth)) && (i == 0 || !schedule_eligible(s, i - 1, depth)))
+            return i == s->nof_gasses ? NULL : s->sorted[i];
+    }
+
+    const int i = schedule_search(s, depth);
+
+    return i == s->nof_gasses ? NULL : s->sorted[i];
+}
+
+/*
+ * Whether the ceiling at gfhi stays at or above the surface after a direct
+ * ascent. Every compartment is taken through the same update and ceiling as
+ * the kernels in turn, without copying the tissues, and the first compartment
+ * that ends up with a ceiling below the surface decides.
+ */
+static int tissues_direct_ascent(const tissues_t *t, const decoconf_t *conf, double depth, double time,
+                                 const gas_t *gas)
+{
+    assert(time > 0);
+
+    const model_t *m = conf->model;
+    const double surface = abs_depth(conf->ctx, 0);
+    const double gf = conf->gfhi / 100.0;
+    const double rate = (surface - depth) / time;
+
+    const double pio_he = gas_he(gas) / 100.0 * (depth - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (depth - m->p_wv);
+    const double r_he = gas_he(gas) / 100.0 * rate;
+    const double r_n2 = gas_n2(gas) / 100.0 * rate;
+
+    /* the tissues stay free of helium, like in the nitrogen only kernels */
+    const int n2_only = !t->he_loaded && gas_he(gas) == 0;
+
+    propagator_t scratch;
+    const propagator_t *p = model_propagator(m, time, &scratch);
+
+    for (int i = 0; i < 16; i++) {
+        double kinv_n2 = m->n2_kinv[i];
+        double pn2 = pio_n2 + r_n2 * (time - kinv_n2) - (pio_n2 - t->pn2[i] - (r_n2 * kinv_n2)) * p->n2_e[i];
+        double c;
+
+        if (n2_only) {
+            c = (pn2 - (m->n2_a[i] * gf)) / (gf / m->n2_b[i] + 1 - gf);
+        } else {
+            double kinv_he = m->he_kinv[i];
+            double phe = pio_he + r_he * (time - kinv_he) - (pio_he - t->phe[i] - (r_he * kinv_he)) * p->he_e[i];
+
+            double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+            double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+            c = ((pn2 + phe) - (a * gf)) / (gf / b + 1 - gf);
+        }
+
+        if (c > surface)
+            return 0;
+    }
+
+    return 1;
+}
+
 int direct_ascent(const decostate_t *ds, double depth, double time, const gas_t *gas)
 {
-    decostate_t ds_ = *ds;
-    assert(ds_.firststop == -1);
+    assert(ds->firststop == -1);
 
-    add_segment_ascdec(&ds_, depth, abs_depth(0), time, gas);
+    return tissues_direct_ascent(&ds->tissues, ds->conf, depth, time, gas);
+}
 
-    return gauge_depth(ceiling(&ds_, ds_.gfhi)) <= 0;
+/* operator of the segment simulate_dive() adds to reach wp from depth */
+void segment_op_waypoint(segment_op_t *op, const model_t *m, double depth, const waypoint_t *wp)
+{
+    if (wp->depth != depth)
+        segment_op_ascdec(op, m, depth, wp->depth, wp->time, wp->gas);
+    else
+        segment_op_const(op, m, wp->depth, wp->time, wp->gas);
 }
 
 void simulate_dive(decostate_t *ds, const waypoint_t *waypoints, int nof_waypoints, const waypoint_callback_t *wp_cb)
 {
-    double depth = abs_depth(0);
+    double depth = abs_depth(ds->conf->ctx, 0);
 
     for (int i = 0; i < nof_waypoints; i++) {
         double d = waypoints[i].depth;
@@ -58,76 +195,249 @@ void simulate_dive(decostate_t *ds, const waypoint_t *waypoints, int nof_waypoin
     }
 }
 
+/*
+ * Tissue pressures of compartment i after time minutes at depth followed by a
+ * direct ascent to the surface, using the same updates as the segment kernels.
+ */
+static void compartment_ascent(const tissues_t *t, const model_t *m, int i, double surface, double depth,
+                               double asc_time, const gas_t *gas, double time, double *phe, double *pn2)
+{
+    const double rate = (surface - depth) / asc_time;
+
+    const double pio_he = gas_he(gas) / 100.0 * (depth - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (depth - m->p_wv);
+    const double r_he = gas_he(gas) / 100.0 * rate;
+    const double r_n2 = gas_n2(gas) / 100.0 * rate;
+
+    double he = t->phe[i] + (pio_he - t->phe[i]) * (1 - exp(-m->he_k[i] * time));
+    double n2 = t->pn2[i] + (pio_n2 - t->pn2[i]) * (1 - exp(-m->n2_k[i] * time));
+
+    double kinv_he = m->he_kinv[i];
+    double kinv_n2 = m->n2_kinv[i];
+
+    *phe = pio_he + r_he * (asc_time - kinv_he) - (pio_he - he - (r_he * kinv_he)) * exp(-m->he_k[i] * asc_time);
+    *pn2 = pio_n2 + r_n2 * (asc_time - kinv_n2) - (pio_n2 - n2 - (r_n2 * kinv_n2)) * exp(-m->n2_k[i] * asc_time);
+}
+
+static int compartment_ascent_fails(const tissues_t *t, const model_t *m, int i, double surface, double depth,
+                                    double asc_time, const gas_t *gas, double time, double gf)
+{
+    double phe, pn2;
+    compartment_ascent(t, m, i, surface, depth, asc_time, gas, time, &phe, &pn2);
+
+    /* same coefficients as the nitrogen only ceiling kernel */
+    if (!t->he_loaded && gas_he(gas) == 0)
+        return (pn2 - (m->n2_a[i] * gf)) / (gf / m->n2_b[i] + 1 - gf) - surface > 0;
+
+    double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+    double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+    return ((pn2 + phe) - (a * gf)) / (gf / b + 1 - gf) - surface > 0;
+}
+
+/*
+ * The NDL is one minute less than the first whole minute at which a direct
+ * ascent would put any compartment's ceiling below the surface. Loading at
+ * depth only raises the post-ascent ceiling of a compartment, so the first
+ * failing minute of each compartment is found by root finding: in closed form
+ * for nitrogen only compartments and by bisection otherwise. Compartments that
+ * still pass one minute before the earliest failure found so far are skipped.
+ */
 double calc_ndl(decostate_t *ds, double depth, double ascrate, const gas_t *gas)
 {
-    double ndl = 0;
+    const tissues_t *t = &ds->tissues;
+    const model_t *m = ds->conf->model;
+    const double gf = ds->conf->gfhi / 100.0;
+    const double surface = abs_depth(ds->conf->ctx, 0);
+    const double asc_time = (depth - surface) / ascrate;
 
-    /* rough steps */
-    decostate_t ds_ = *ds;
+    int first_fail = NDL_MAX + 1;
 
-    while (ndl < 360) {
-        double tmp = add_segment_const(&ds_, depth, STOPLEN_ROUGH, gas);
+    assert(ds->firststop == -1);
 
-        if (!direct_ascent(&ds_, depth, gauge_depth(depth) / ascrate, gas))
-            break;
+    for (int i = 0; i < 16; i++) {
+        if (!compartment_ascent_fails(t, m, i, surface, depth, asc_time, gas, first_fail - 1, gf))
+            continue;
 
-        ndl += tmp;
-    }
+        /* invariant: passes at lo (or lo is 0), fails at hi */
+        int lo = 0;
+        int hi = first_fail - 1;
 
-    /* fine steps */
-    ds_ = *ds;
+        if (gas_he(gas) == 0 && t->phe[i] == 0) {
+            /* the surfacing pressure is pn2(time) = inf + (zero - inf) * exp(-k * time) */
+            double phe, zero, inf;
+            compartment_ascent(t, m, i, surface, depth, asc_time, gas, 0, &phe, &zero);
+            compartment_ascent(t, m, i, surface, depth, asc_time, gas, INFINITY, &phe, &inf);
 
-    if (ndl)
-        add_segment_const(&ds_, depth, ndl, gas);
+            double limit = surface * (gf / m->n2_b[i] + 1 - gf) + m->n2_a[i] * gf;
+            double time = -log((limit - inf) / (zero - inf)) / m->n2_k[i];
 
-    while (ndl < 360) {
-        double tmp = add_segment_const(&ds_, depth, STOPLEN_FINE, gas);
+            if (isfinite(time) && time >= 0)
+                hi = min(hi, max(1, (int) floor(time) + 1));
+
+            /* nudge across rounding errors of the closed form */
+            while (!compartment_ascent_fails(t, m, i, surface, depth, asc_time, gas, hi, gf))
+                hi++;
+
+            while (hi > 1 && compartment_ascent_fails(t, m, i, surface, depth, asc_time, gas, hi - 1, gf))
+                hi--;
+
+            lo = hi - 1;
+        }
 
-        if (!direct_ascent(&ds_, depth, gauge_depth(depth) / ascrate, gas))
-            break;
+        while (hi - lo > 1) {
+            int mid = lo + (hi - lo) / 2;
 
-        ndl += tmp;
+            if (compartment_ascent_fails(t, m, i, surface, depth, asc_time, gas, mid, gf))
+                hi = mid;
+            else
+                lo = mid;
+        }
+
+        first_fail = hi;
     }
 
-    return ndl;
+    return first_fail - 1;
 }
 
-double deco_stop(decostate_t *ds, double depth, double next_stop, double current_gf, const gas_t *gas)
+static double compartment_ceiling(const tissues_t *t, const model_t *m, int i, double pio_he, double pio_n2,
+                                  double time, double gf)
+{
+    /* same update as the constant depth segment kernel */
+    double phe = t->phe[i] + (pio_he - t->phe[i]) * (1 - exp(-m->he_k[i] * time));
+    double pn2 = t->pn2[i] + (pio_n2 - t->pn2[i]) * (1 - exp(-m->n2_k[i] * time));
+
+    if (!t->he_loaded && pio_he == 0)
+        return (pn2 - (m->n2_a[i] * gf)) / (gf / m->n2_b[i] + 1 - gf);
+
+    double a = ((m->n2_a[i] * pn2) + (m->he_a[i] * phe)) / (pn2 + phe);
+    double b = ((m->n2_b[i] * pn2) + (m->he_b[i] * phe)) / (pn2 + phe);
+
+    return ((pn2 + phe) - (a * gf)) / (gf / b + 1 - gf);
+}
+
+/*
+ * Find the shortest stop, in multiples of STOPLEN_FINE, after which the
+ * ceiling is at or above next_stop. Every compartment off-gasses towards its
+ * inspired pressure at the stop, so its ceiling only decreases and the stop
+ * length is the maximum over the compartments of the time each of them needs.
+ * Compartments that already clear the running maximum are skipped. Nitrogen
+ * only compartments are solved in closed form, mixed ones by bisection on the
+ * stop grid. Returns INFINITY if a compartment can never clear next_stop.
+ */
+double tissues_stop_time(const tissues_t *t, const model_t *m, double depth, const gas_t *gas, double gf,
+                         double next_stop)
 {
+    const double pio_he = gas_he(gas) / 100.0 * (depth - m->p_wv);
+    const double pio_n2 = gas_n2(gas) / 100.0 * (depth - m->p_wv);
+
     double stoplen = 0;
+    gf /= 100;
 
-    /* rough steps */
-    decostate_t ds_ = *ds;
+    for (int i = 0; i < 16; i++) {
+        if (compartment_ceiling(t, m, i, pio_he, pio_n2, stoplen, gf) <= next_stop)
+            continue;
 
-    for (;;) {
-        double tmp = add_segment_const(&ds_, depth, STOPLEN_ROUGH, gas);
+        /* ceiling once the compartment is saturated at the stop */
+        if (compartment_ceiling(t, m, i, pio_he, pio_n2, INFINITY, gf) > next_stop)
+            return INFINITY;
+
+        double lo = stoplen;
+        double hi;
+
+        if (pio_he == 0 && t->phe[i] == 0) {
+            /* solve pio + (p - pio) * exp(-k * t) = limit for t */
+            double limit = next_stop * (gf / m->n2_b[i] + 1 - gf) + m->n2_a[i] * gf;
+            double time = -log((limit - pio_n2) / (t->pn2[i] - pio_n2)) / m->n2_k[i];
+
+            hi = max(lo + STOPLEN_FINE, STOPLEN_FINE * ceil(time / STOPLEN_FINE));
+
+            /* nudge across rounding errors of the closed form */
+            while (compartment_ceiling(t, m, i, pio_he, pio_n2, hi, gf) > next_stop)
+                hi += STOPLEN_FINE;
 
-        if (ceiling(&ds_, current_gf) <= next_stop)
-            break;
+            while (hi - STOPLEN_FINE > lo &&
+                   compartment_ceiling(t, m, i, pio_he, pio_n2, hi - STOPLEN_FINE, gf) <= next_stop)
+                hi -= STOPLEN_FINE;
+
+            lo = hi - STOPLEN_FINE;
+        } else {
+            hi = lo + STOPLEN_ROUGH;
+
+            while (compartment_ceiling(t, m, i, pio_he, pio_n2, hi, gf) > next_stop) {
+                lo = hi;
+                hi += 2 * (hi - stoplen);
+            }
+        }
+
+        /* invariant: ceiling above next_stop at lo, at or below at hi */
+        while (hi - lo > STOPLEN_FINE) {
+            double mid = lo + STOPLEN_FINE * floor((hi - lo) / STOPLEN_FINE / 2);
+
+            if (compartment_ceiling(t, m, i, pio_he, pio_n2, mid, gf) > next_stop)
+                lo = mid;
+            else
+                hi = mid;
+        }
 
-        stoplen += tmp;
+        stoplen = hi;
     }
 
+    return stoplen;
+}
+
+double deco_stop(decostate_t *ds, double depth, double next_stop, double current_gf, const gas_t *gas)
+{
+    double stoplen = tissues_stop_time(&ds->tissues, ds->conf->model, depth, gas, current_gf, next_stop);
+
+    /* no stop clears next_stop, leave the tissues as they are */
+    if (isinf(stoplen))
+        return stoplen;
+
     if (stoplen)
         add_segment_const(ds, depth, stoplen, gas);
 
-    /* fine steps */
+    /* step on if a compartment still on-gasses at this stop */
     while (ceiling(ds, current_gf) > next_stop)
         stoplen += add_segment_const(ds, depth, STOPLEN_FINE, gas);
 
     return stoplen;
 }
 
-static int surfaced(double depth)
+int surfaced(const opendeco_ctx *ctx, double depth)
 {
-    return fabs(depth - SURFACE_PRESSURE) < 1E-2;
+    return fabs(depth - opendeco_ctx_surface_pressure(ctx)) < 1E-2;
 }
 
 decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas, const gas_t *deco_gasses,
                      int nof_gasses, const waypoint_callback_t *wp_cb)
+{
+    gas_schedule_t schedule;
+    init_gas_schedule(&schedule, ds->conf, deco_gasses, nof_gasses);
+
+    return calc_deco_schedule(ds, start_depth, start_gas, &schedule, wp_cb);
+}
+
+/* calc_deco() with a gas schedule that can be shared between plans */
+decoinfo_t calc_deco_schedule(decostate_t *ds, double start_depth, const gas_t *start_gas,
+                              const gas_schedule_t *deco_gasses, const waypoint_callback_t *wp_cb)
+{
+    return calc_deco_bounded(ds, start_depth, start_gas, deco_gasses, wp_cb, INFINITY);
+}
+
+/*
+ * calc_deco_schedule() that gives up after the first stop that takes the tts
+ * beyond tts_max. The tts returned then exceeds tts_max and only covers the
+ * ascent so far, ds is left at that stop. The tts is INFINITY if a stop never
+ * clears the ceiling on its gas.
+ */
+decoinfo_t calc_deco_bounded(decostate_t *ds, double start_depth, const gas_t *start_gas,
+                             const gas_schedule_t *deco_gasses, const waypoint_callback_t *wp_cb, double tts_max)
 {
     decoinfo_t ret = {.tts = 0, .ndl = 0};
 
+    const opendeco_ctx *ctx = ds->conf->ctx;
+
     /* setup start parameters */
     double depth = start_depth;
     const gas_t *gas = start_gas;
@@ -135,15 +445,16 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
     const double asc_per_min = msw_to_bar(9);
 
     /* check if direct ascent is possible */
-    if (direct_ascent(ds, depth, gauge_depth(depth) / asc_per_min, gas)) {
+    if (direct_ascent(ds, depth, gauge_depth(ctx, depth) / asc_per_min, gas)) {
         ret.ndl = calc_ndl(ds, depth, asc_per_min, gas);
         return ret;
     }
 
-    double next_stop = abs_depth(ds->ceil_multiple * (ceil(gauge_depth(depth) / ds->ceil_multiple) - 1));
+    double next_stop =
+        abs_depth(ctx, ds->conf->ceil_multiple * (ceil(gauge_depth(ctx, depth) / ds->conf->ceil_multiple) - 1));
 
     if (next_stop == depth)
-        next_stop -= ds->ceil_multiple;
+        next_stop -= ds->conf->ceil_multiple;
 
     double current_gf = get_gf(ds, next_stop);
 
@@ -152,11 +463,11 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
     double waypoint_time;
 
     for (;;) {
-        while (ceiling(ds, current_gf) < next_stop && !surfaced(depth)) {
+        while (ceiling(ds, current_gf) < next_stop && !surfaced(ctx, depth)) {
             /* switch to better gas if available */
-            const gas_t *best = best_gas(depth, deco_gasses, nof_gasses);
+            const gas_t *best = gas_schedule_best(deco_gasses, depth);
 
-            if (SWITCH_INTERMEDIATE && best && best != gas) {
+            if (opendeco_ctx_switch_intermediate(ctx) && best && best != gas) {
                 /* emit waypoint */
                 waypoint_time = fabs(last_waypoint_depth - depth) / asc_per_min;
 
@@ -178,14 +489,14 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
             }
 
             /* ascend to next stop */
-            ret.tts += add_segment_ascdec(ds, depth, next_stop, fabs(depth - next_stop) / asc_per_min, gas);
+            ret.tts += add_segment_ascdec(ds, depth, next_stop, decoconf_ascent_time(ds->conf, depth, next_stop), gas);
             depth = next_stop;
 
             /* make next stop shallower */
-            next_stop -= ds->ceil_multiple;
+            next_stop -= ds->conf->ceil_multiple;
 
-            if (LAST_STOP_AT_SIX && next_stop < abs_depth(msw_to_bar(6)))
-                next_stop = SURFACE_PRESSURE;
+            if (opendeco_ctx_last_stop_at_six(ctx) && next_stop < abs_depth(ctx, msw_to_bar(6)))
+                next_stop = opendeco_ctx_surface_pressure(ctx);
 
             /* recalculate gf */
             current_gf = get_gf(ds, next_stop);
@@ -207,7 +518,7 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
 
         /* emit waypoint */
         waypoint_time = fabs(last_waypoint_depth - depth) / asc_per_min;
-        enum segtype_t segtype = surfaced(depth) ? SEG_SURFACE : SEG_TRAVEL;
+        enum segtype_t segtype = surfaced(ctx, depth) ? SEG_SURFACE : SEG_TRAVEL;
 
         if (wp_cb && wp_cb->fn && waypoint_time)
             wp_cb->fn(ds, (waypoint_t){.depth = depth, .time = waypoint_time, .gas = gas}, segtype, wp_cb->arg);
@@ -215,11 +526,11 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
         last_waypoint_depth = depth;
 
         /* terminate if we surfaced */
-        if (surfaced(depth))
+        if (surfaced(ctx, depth))
             return ret;
 
         /* switch to better gas if available */
-        const gas_t *best = best_gas(depth, deco_gasses, nof_gasses);
+        const gas_t *best = gas_schedule_best(deco_gasses, depth);
 
         if (best)
             gas = best;
@@ -229,7 +540,42 @@ decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas
 
         ret.tts += stoplen;
 
+        if (isinf(stoplen))
+            return ret;
+
         if (wp_cb && wp_cb->fn)
             wp_cb->fn(ds, (waypoint_t){.depth = depth, .time = stoplen, .gas = gas}, SEG_DECO_STOP, wp_cb->arg);
+
+        if (ret.tts > tts_max)
+            return ret;
+    }
+}
+
+static void record_stop(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    decoplan_t *plan = arg;
+
+    if ((type != SEG_DECO_STOP && type != SEG_GAS_SWITCH) || !wp.time)
+        return;
+
+    /* a gas switch and the stop that follows it at the same depth merge */
+    if (plan->nof_stops && plan->stops[plan->nof_stops - 1].depth == wp.depth) {
+        plan->stops[plan->nof_stops - 1].time += wp.time;
+        plan->stops[plan->nof_stops - 1].gas = wp.gas;
+    } else if (plan->nof_stops < DECOPLAN_STOPS) {
+        plan->stops[plan->nof_stops++] = wp;
     }
 }
+
+/* calc_deco_schedule() that records its stops, stops beyond DECOPLAN_STOPS are dropped */
+void calc_deco_plan(decoplan_t *plan, decostate_t *ds, double start_depth, const gas_t *start_gas,
+                    const gas_schedule_t *deco_gasses)
+{
+    waypoint_callback_t wp_cb = {
+        .fn = &record_stop,
+        .arg = plan,
+    };
+
+    plan->nof_stops = 0;
+    plan->info = calc_deco_schedule(ds, start_depth, start_gas, deco_gasses, &wp_cb);
+}
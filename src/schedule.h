@@ -5,7 +5,10 @@
 
 #include "deco.h"
 
-#define SWITCH_INTERMEDIATE_DEFAULT 1
+#define GAS_SCHEDULE_GASSES 8
+#define GAS_SCHEDULE_STOPS 128
+#define DECOPLAN_STOPS 128
+#define NDL_MAX 360 /* minutes, calc_ndl() looks no further */
 
 /* types */
 typedef struct waypoint_t {
@@ -14,11 +17,32 @@ typedef struct waypoint_t {
     const gas_t *gas;
 } waypoint_t;
 
+/* the deco gas best_gas() picks at every stop, gasses must outlive the schedule */
+typedef struct gas_schedule_t {
+    const gas_t *gasses; /* as passed in, searched by best_gas() if there are too many to sort */
+    int nof_gasses;
+
+    const gas_t *sorted[GAS_SCHEDULE_GASSES]; /* by increasing mod, stable */
+    double mod[GAS_SCHEDULE_GASSES];
+
+    double surface;
+    double ceil_multiple;
+    int nof_stops;
+    unsigned char stop_gas[GAS_SCHEDULE_STOPS]; /* index into sorted, nof_gasses if none */
+} gas_schedule_t;
+
 typedef struct decoinfo_t {
     double ndl;
     double tts;
 } decoinfo_t;
 
+/* the stops of a calc_deco() run, gas switches count as a stop of their own */
+typedef struct decoplan_t {
+    decoinfo_t info;
+    int nof_stops;
+    waypoint_t stops[DECOPLAN_STOPS];
+} decoplan_t;
+
 typedef enum segtype_t {
     SEG_DECO_STOP,
     SEG_DIVE,
@@ -34,18 +58,29 @@ typedef struct waypoint_callback_t {
     void *arg;
 } waypoint_callback_t;
 
-/* global variables */
-extern int SWITCH_INTERMEDIATE;
-
 /* functions */
+int surfaced(const opendeco_ctx *ctx, double depth);
 const gas_t *best_gas(double depth, const gas_t *gasses, int nof_gasses);
 
+void init_gas_schedule(gas_schedule_t *s, const decoconf_t *conf, const gas_t *gasses, int nof_gasses);
+const gas_t *gas_schedule_best(const gas_schedule_t *s, double depth);
+
 int direct_ascent(const decostate_t *ds, double depth, double time, const gas_t *gas);
 double calc_ndl(decostate_t *ds, double depth, double ascrate, const gas_t *gas);
+double tissues_stop_time(const tissues_t *t, const model_t *m, double depth, const gas_t *gas, double gf,
+                         double next_stop);
+double deco_stop(decostate_t *ds, double depth, double next_stop, double current_gf, const gas_t *gas);
 
+void segment_op_waypoint(segment_op_t *op, const model_t *m, double depth, const waypoint_t *wp);
 void simulate_dive(decostate_t *ds, const waypoint_t *waypoints, int nof_waypoints, const waypoint_callback_t *wp_cb);
 
 decoinfo_t calc_deco(decostate_t *ds, double start_depth, const gas_t *start_gas, const gas_t *deco_gasses,
                      int nof_gasses, const waypoint_callback_t *wp_cb);
+decoinfo_t calc_deco_schedule(decostate_t *ds, double start_depth, const gas_t *start_gas,
+                              const gas_schedule_t *deco_gasses, const waypoint_callback_t *wp_cb);
+decoinfo_t calc_deco_bounded(decostate_t *ds, double start_depth, const gas_t *start_gas,
+                             const gas_schedule_t *deco_gasses, const waypoint_callback_t *wp_cb, double tts_max);
+void calc_deco_plan(decoplan_t *plan, decostate_t *ds, double start_depth, const gas_t *start_gas,
+                    const gas_schedule_t *deco_gasses);
 
 #endif /* end of include guard: SCHEDULE_H */
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "sweep.h"
+
+static void plan_cell(void *arg, int i)
+{
+    gf_sweep_t *sweep = arg;
+
+    const int lo = sweep->gflo[i / sweep->nof_gfhi];
+    const int hi = sweep->gfhi[i % sweep->nof_gfhi];
+
+    if (lo > hi) {
+        sweep->info[i] = (decoinfo_t){.tts = -1, .ndl = 0};
+        return;
+    }
+
+    /* the tissues do not depend on the gradient factors, only the deco does */
+    decoconf_t conf;
+    init_decoconf(&conf, sweep->ds.conf->ctx, lo, hi, sweep->ds.conf->ceil_multiple);
+
+    decostate_t ds = sweep->ds;
+    ds.conf = &conf;
+
+    sweep->info[i] = calc_deco_schedule(&ds, sweep->depth, sweep->gas, &sweep->schedule, NULL);
+}
+
+/*
+ * The first stop calc_deco_schedule() settles on for every gf low. Until a
+ * plan stops, its ascent only depends on gf low through the ceiling it checks,
+ * so all gf lows share one ascent from stop to stop, with the same gas
+ * switches, and their ceilings are evaluated together at every step.
+ */
+static void first_stops(gf_sweep_t *sweep, const double *gf, double *c)
+{
+    const decoconf_t *conf = sweep->ds.conf;
+    const opendeco_ctx *ctx = conf->ctx;
+
+    decostate_t ds = sweep->ds;
+    double depth = sweep->depth;
+    const gas_t *gas = sweep->gas;
+
+    double next_stop =
+        abs_depth(ctx, conf->ceil_multiple * (ceil(gauge_depth(ctx, depth) / conf->ceil_multiple) - 1));
+
+    if (next_stop == depth)
+        next_stop -= conf->ceil_multiple;
+
+    for (int i = 0; i < sweep->nof_gflo; i++)
+        sweep->firststop[i] = -1;
+
+    for (int nof_stopped = 0;;) {
+        ceilings(&ds, gf, sweep->nof_gflo, c);
+
+        for (int i = 0; i < sweep->nof_gflo; i++) {
+            if (sweep->firststop[i] == -1 && (c[i] >= next_stop || surfaced(ctx, depth))) {
+                sweep->firststop[i] = depth;
+                nof_stopped++;
+            }
+        }
+
+        if (nof_stopped == sweep->nof_gflo)
+            return;
+
+        const gas_t *best = gas_schedule_best(&sweep->schedule, depth);
+
+        if (opendeco_ctx_switch_intermediate(ctx) && best && best != gas) {
+            gas = best;
+            add_segment_const(&ds, depth, 1, gas);
+            continue;
+        }
+
+        add_segment_ascdec(&ds, depth, next_stop, decoconf_ascent_time(conf, depth, next_stop), gas);
+        depth = next_stop;
+
+        next_stop -= conf->ceil_multiple;
+
+        if (opendeco_ctx_last_stop_at_six(ctx) && next_stop < abs_depth(ctx, msw_to_bar(6)))
+            next_stop = opendeco_ctx_surface_pressure(ctx);
+    }
+}
+
+/*
+ * Plan the ascent from the end of the dive phase in ds for every combination
+ * of gf low and gf high. The tissues at the end of the dive phase are shared
+ * by all combinations, which are planned concurrently on the pool. The first
+ * stops of all gf lows are found in a single ascent beforehand. Returns -1 if
+ * memory cannot be allocated.
+ */
+int gf_sweep(gf_sweep_t *sweep, const decostate_t *ds, double depth, const gas_t *gas, const int *gflo, int nof_gflo,
+             const int *gfhi, int nof_gfhi, const gas_t *deco_gasses, int nof_gasses, pool_t *pool)
+{
+    sweep->ds = *ds;
+    sweep->depth = depth;
+    sweep->gas = gas;
+    sweep->nof_gflo = nof_gflo;
+    sweep->nof_gfhi = nof_gfhi;
+
+    init_gas_schedule(&sweep->schedule, ds->conf, deco_gasses, nof_gasses);
+
+    sweep->gflo = malloc(nof_gflo * sizeof(int));
+    sweep->gfhi = malloc(nof_gfhi * sizeof(int));
+    sweep->firststop = malloc(nof_gflo * sizeof(double));
+    sweep->info = malloc(nof_gflo * nof_gfhi * sizeof(decoinfo_t));
+
+    double *gf = malloc(2 * nof_gflo * sizeof(double));
+
+    if (!sweep->gflo || !sweep->gfhi || !sweep->firststop || !sweep->info || !gf) {
+        free(gf);
+        free_gf_sweep(sweep);
+        return -1;
+    }
+
+    for (int i = 0; i < nof_gflo; i++) {
+        sweep->gflo[i] = gflo[i];
+        gf[i] = gflo[i];
+    }
+
+    for (int i = 0; i < nof_gfhi; i++)
+        sweep->gfhi[i] = gfhi[i];
+
+    first_stops(sweep, gf, gf + nof_gflo);
+    free(gf);
+
+    pool_for(pool, nof_gflo * nof_gfhi, &plan_cell, sweep);
+
+    return 0;
+}
+
+void free_gf_sweep(gf_sweep_t *sweep)
+{
+    free(sweep->gflo);
+    free(sweep->gfhi);
+    free(sweep->firststop);
+    free(sweep->info);
+
+    sweep->gflo = NULL;
+    sweep->gfhi = NULL;
+    sweep->firststop = NULL;
+    sweep->info = NULL;
+    sweep->nof_gflo = 0;
+    sweep->nof_gfhi = 0;
+}
+
+const decoinfo_t *gf_sweep_info(const gf_sweep_t *sweep, int gflo, int gfhi)
+{
+    return &sweep->info[gflo * sweep->nof_gfhi + gfhi];
+}
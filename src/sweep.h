@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "deco.h"
+#include "pool.h"
+#include "schedule.h"
+
+/* types */
+typedef struct gf_sweep_t {
+    decostate_t ds; /* the tissues at the end of the dive phase */
+    double depth;
+    const gas_t *gas;
+    gas_schedule_t schedule;
+
+    int nof_gflo;
+    int nof_gfhi;
+    int *gflo;
+    int *gfhi;
+    double *firststop; /* of every gf low, for the plans that do not ascend directly */
+    decoinfo_t *info;  /* nof_gfhi results for every gf low, tts is -1 if gf low exceeds gf high */
+} gf_sweep_t;
+
+/* functions */
+int gf_sweep(gf_sweep_t *sweep, const decostate_t *ds, double depth, const gas_t *gas, const int *gflo, int nof_gflo,
+             const int *gfhi, int nof_gfhi, const gas_t *deco_gasses, int nof_gasses, pool_t *pool);
+void free_gf_sweep(gf_sweep_t *sweep);
+
+const decoinfo_t *gf_sweep_info(const gf_sweep_t *sweep, int gflo, int gfhi);
+
+#endif /* end of include guard: SWEEP_H */
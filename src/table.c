@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "table.h"
+
+static void plan_row(void *arg, int d)
+{
+    dive_table_t *table = arg;
+
+    const opendeco_ctx *ctx = table->conf->ctx;
+    const double depth = table->depths[d];
+
+    /* descents and ascents at 9m/min, as in the dive plan */
+    const double travel_time = gauge_depth(ctx, depth) / msw_to_bar(9);
+
+    decostate_t ds;
+    init_decostate(&ds, table->conf);
+
+    /* same segments as simulate_dive() */
+    add_segment_ascdec(&ds, abs_depth(ctx, 0), depth, travel_time, table->gas);
+
+    double ndl = direct_ascent(&ds, depth, travel_time, table->gas) ? calc_ndl(&ds, depth, msw_to_bar(9), table->gas)
+                                                                     : -1;
+
+    if (ndl >= NDL_MAX)
+        table->ndl[d] = INFINITY;
+    else if (ndl >= 0)
+        table->ndl[d] = travel_time + ndl;
+    else
+        table->ndl[d] = 0;
+
+    /* every time extends the bottom phase of the previous one */
+    double bottom_time = 0;
+
+    for (int t = 0; t < table->nof_times; t++) {
+        double time = max(1, table->times[t] - travel_time);
+
+        if (time > bottom_time)
+            add_segment_const(&ds, depth, time - bottom_time, table->gas);
+
+        bottom_time = max(bottom_time, time);
+
+        decostate_t fork = ds;
+        calc_deco_plan(&table->plans[d * table->nof_times + t], &fork, depth, table->gas, &table->schedule);
+    }
+}
+
+/*
+ * Plan the dive to every depth for every time on gas. The times of a depth
+ * share a single decostate that is extended from one bottom time to the next,
+ * and the depths are planned concurrently on the pool. Also determines the
+ * NDL at every depth. Returns -1 if memory cannot be allocated.
+ */
+int dive_table(dive_table_t *table, const decoconf_t *conf, const double *depths, int nof_depths,
+               const double *times, int nof_times, const gas_t *gas, const gas_t *deco_gasses, int nof_gasses,
+               pool_t *pool)
+{
+    table->conf = conf;
+    table->gas = gas;
+    table->nof_depths = nof_depths;
+    table->nof_times = nof_times;
+
+    init_gas_schedule(&table->schedule, conf, deco_gasses, nof_gasses);
+
+    table->depths = malloc(nof_depths * sizeof(double));
+    table->times = malloc(nof_times * sizeof(double));
+    table->ndl = malloc(nof_depths * sizeof(double));
+    table->plans = malloc(nof_depths * nof_times * sizeof(decoplan_t));
+
+    if (!table->depths || !table->times || !table->ndl || !table->plans) {
+        free_dive_table(table);
+        return -1;
+    }
+
+    for (int d = 0; d < nof_depths; d++)
+        table->depths[d] = depths[d];
+
+    for (int t = 0; t < nof_times; t++)
+        table->times[t] = times[t];
+
+    pool_for(pool, nof_depths, &plan_row, table);
+
+    return 0;
+}
+
+void free_dive_table(dive_table_t *table)
+{
+    free(table->depths);
+    free(table->times);
+    free(table->ndl);
+    free(table->plans);
+
+    table->depths = NULL;
+    table->times = NULL;
+    table->ndl = NULL;
+    table->plans = NULL;
+    table->nof_depths = 0;
+    table->nof_times = 0;
+}
+
+const decoplan_t *dive_table_plan(const dive_table_t *table, int depth, int time)
+{
+    return &table->plans[depth * table->nof_times + time];
+}
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "deco.h"
+#include "pool.h"
+#include "schedule.h"
+
+/* types */
+typedef struct dive_table_t {
+    const decoconf_t *conf;
+    const gas_t *gas;
+    gas_schedule_t schedule;
+
+    int nof_depths;
+    int nof_times;
+    double *depths;    /* ascending */
+    double *times;     /* runtime at the start of the ascent in minutes, ascending */
+    double *ndl;       /* runtime at which every depth starts to require deco, INFINITY past NDL_MAX */
+    decoplan_t *plans; /* nof_times plans for every depth */
+} dive_table_t;
+
+/* functions */
+int dive_table(dive_table_t *table, const decoconf_t *conf, const double *depths, int nof_depths,
+               const double *times, int nof_times, const gas_t *gas, const gas_t *deco_gasses, int nof_gasses,
+               pool_t *pool);
+void free_dive_table(dive_table_t *table);
+
+const decoplan_t *dive_table_plan(const dive_table_t *table, int depth, int time);
+
+#endif /* end of include guard: TABLE_H */
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "minunit/minunit.h"
+
+#include "src/archive.h"
+#include "src/deco.h"
+#include "src/divelog.h"
+#include "src/pool.h"
+
+#define NOF_LOGS 40
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+static char dir[64];
+
+/* a square dive to depth for time minutes and a direct ascent, in 10 second samples */
+static void write_log(const char *name, int depth, int time)
+{
+    char path[96];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE *file = fopen(path, "w");
+
+    fprintf(file, "time,depth\n");
+
+    for (int s = 0; s <= time * 6; s++)
+        fprintf(file, "%i,%.1f\n", s * 10, min(depth, s * 1.5));
+
+    fprintf(file, "%i,0\n", time * 60 + depth * 6);
+    fclose(file);
+}
+
+MU_TEST(test_list_archive)
+{
+    char **paths;
+    mu_check(list_archive(&paths, dir) == NOF_LOGS + 1);
+
+    /* sorted by name, whatever order readdir() returns */
+    for (int i = 1; i < NOF_LOGS + 1; i++)
+        mu_check(strcmp(paths[i - 1], paths[i]) < 0);
+
+    /* a list of files keeps its order */
+    char list[96];
+    snprintf(list, sizeof(list), "%s.list", dir);
+
+    FILE *file = fopen(list, "w");
+    fprintf(file, "# comment\n%s\n\n%s\n", paths[3], paths[1]);
+    fclose(file);
+
+    char **listed;
+    mu_check(list_archive(&listed, list) == 2);
+    mu_check(!strcmp(listed[0], paths[3]) && !strcmp(listed[1], paths[1]));
+
+    free_archive_list(listed, 2);
+    free_archive_list(paths, NOF_LOGS + 1);
+    unlink(list);
+
+    mu_check(list_archive(&paths, "/nonexistent/opendeco") == -1);
+}
+
+MU_TEST(test_analyze_archive)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    char **paths;
+    int nof_paths = list_archive(&paths, dir);
+    mu_check(nof_paths == NOF_LOGS + 1);
+
+    pool_t *pool = pool_new(4);
+    log_archive_t archive[2];
+
+    mu_check(analyze_archive(&archive[0], &conf, &air, paths, nof_paths, 0, NULL) == 0);
+    mu_check(analyze_archive(&archive[1], &conf, &air, paths, nof_paths, 0, pool) == 0);
+
+    /* the pool only changes who replays a log, not the summaries nor their order */
+    for (int i = 0; i < nof_paths; i++) {
+        const dive_summary_t *a = &archive[0].dives[i];
+        const dive_summary_t *b = &archive[1].dives[i];
+
+        mu_check(a->path == paths[i] && b->path == paths[i]);
+        mu_check(a->status == b->status && a->nof_samples == b->nof_samples);
+        mu_assert_double_eq(a->max_gf99, b->max_gf99);
+        mu_assert_double_eq(a->max_violation, b->max_violation);
+        mu_assert_double_eq(a->tissues.pn2[0], b->tissues.pn2[0]);
+    }
+
+    /* the invalid log sorts last */
+    const dive_summary_t *invalid = &archive[0].dives[NOF_LOGS];
+    mu_check(invalid->status == DIVE_INVALID);
+    mu_check(invalid->line == 3);
+
+    /* a summary matches replaying its log on its own */
+    const dive_summary_t *dive = &archive[1].dives[NOF_LOGS - 1];
+    mu_check(dive->status == DIVE_OK);
+
+    FILE *file = fopen(dive->path, "r");
+    divelog_t log;
+    mu_check(init_divelog(&log, file, ctx, &air) == 0);
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+    mu_check(replay_log(&ds, &log, NULL, NULL) == dive->nof_samples);
+
+    for (int j = 0; j < 16; j++)
+        mu_assert_double_eq(ds.tissues.pn2[j], dive->tissues.pn2[j]);
+
+    mu_assert_double_near(gf99(&ds, abs_depth(NULL, 0)), dive->surf_gf, 1E-9);
+
+    /* the deepest, longest dive surfaces straight through its ceiling */
+    mu_check(dive->max_gf99 > conf.gfhi);
+    mu_check(dive->max_violation > 0);
+    mu_assert_double_near(abs_depth(NULL, msw_to_bar(39)), dive->max_depth, 1E-9);
+
+    free_divelog(&log);
+    fclose(file);
+
+    free_log_archive(&archive[0]);
+    free_log_archive(&archive[1]);
+    free_archive_list(paths, nof_paths);
+    pool_free(pool);
+}
+
+void testsuite_archive_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+
+    /* a fresh directory of logs for every test */
+    snprintf(dir, sizeof(dir), "/tmp/opendeco_archive_XXXXXX");
+    mkdtemp(dir);
+
+    for (int i = 0; i < NOF_LOGS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "dive%02i.csv", i);
+        write_log(name, 20 + i / 2, 10 + i);
+    }
+
+    char path[96];
+    snprintf(path, sizeof(path), "%s/zzz.csv", dir);
+
+    FILE *file = fopen(path, "w");
+    fprintf(file, "0,0\n60,10\n30,10\n");
+    fclose(file);
+}
+
+void testsuite_archive_teardown(void)
+{
+    char **paths;
+    int nof_paths = list_archive(&paths, dir);
+
+    for (int i = 0; i < nof_paths; i++)
+        unlink(paths[i]);
+
+    free_archive_list(paths, nof_paths);
+    rmdir(dir);
+
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_archive)
+{
+    MU_SUITE_CONFIGURE(&testsuite_archive_setup, &testsuite_archive_teardown);
+
+    MU_RUN_TEST(test_list_archive);
+    MU_RUN_TEST(test_analyze_archive);
+}
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include "minunit/minunit.h"
+
+#include "src/batch.h"
+#include "src/deco.h"
+#include "src/schedule.h"
+
+#define NOF_PLANS 11
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+MU_TEST(test_batch_segments)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t tmx = gas_new(NULL, 18, 45, MOD_AUTO);
+
+    decostate_batch_t b;
+    mu_check(init_decostate_batch(&b, &conf, NOF_PLANS) == 0);
+
+    decostate_t ds[NOF_PLANS];
+
+    double dstart[NOF_PLANS];
+    double dend[NOF_PLANS];
+    double time[NOF_PLANS];
+    const gas_t *gas[NOF_PLANS];
+
+    for (int j = 0; j < NOF_PLANS; j++) {
+        init_decostate(&ds[j], &conf);
+
+        dstart[j] = abs_depth(NULL, 0);
+        dend[j] = abs_depth(NULL, msw_to_bar(20 + 5 * j));
+        time[j] = 2 + j / 3.0;
+        gas[j] = j & 1 ? &tmx : &air;
+    }
+
+    /* every third plan skips the bottom segment */
+    batch_add_segment_ascdec(&b, dstart, dend, time, gas);
+
+    for (int j = 0; j < NOF_PLANS; j++) {
+        add_segment_ascdec(&ds[j], dstart[j], dend[j], time[j], gas[j]);
+        time[j] = j % 3 ? 10 + j : 0;
+    }
+
+    batch_add_segment_const(&b, dend, time, gas);
+
+    double gf[NOF_PLANS];
+    double c[NOF_PLANS];
+
+    for (int j = 0; j < NOF_PLANS; j++) {
+        if (time[j])
+            add_segment_const(&ds[j], dend[j], time[j], gas[j]);
+
+        gf[j] = 30 + 5 * j;
+    }
+
+    batch_ceiling(&b, gf, c);
+
+    /* the batch performs the same operations as the scalar path */
+    for (int j = 0; j < NOF_PLANS; j++) {
+        decostate_t ds_;
+        batch_get_plan(&b, j, &ds_);
+
+        for (int i = 0; i < 16; i++) {
+            mu_check(ds_.tissues.phe[i] == ds[j].tissues.phe[i]);
+            mu_check(ds_.tissues.pn2[i] == ds[j].tissues.pn2[i]);
+        }
+
+        mu_check(c[j] == ceiling(&ds[j], gf[j]));
+        mu_assert_double_eq(ds[j].max_depth, ds_.max_depth);
+    }
+
+    /* the padding lanes still hold surface tissues */
+    decostate_t surface;
+    init_decostate(&surface, &conf);
+
+    for (int j = NOF_PLANS; j < b.stride; j++) {
+        decostate_t ds_;
+        batch_get_plan(&b, j, &ds_);
+
+        for (int i = 0; i < 16; i++) {
+            mu_check(ds_.tissues.phe[i] == surface.tissues.phe[i]);
+            mu_check(ds_.tissues.pn2[i] == surface.tissues.pn2[i]);
+        }
+    }
+
+    free_decostate_batch(&b);
+}
+
+MU_TEST(test_batch_calc_deco)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t tmx = gas_new(NULL, 18, 45, MOD_AUTO);
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    decostate_batch_t b;
+    mu_check(init_decostate_batch(&b, &conf, NOF_PLANS) == 0);
+
+    decostate_t ds[NOF_PLANS];
+
+    double depth[NOF_PLANS];
+    const gas_t *gas[NOF_PLANS];
+
+    /* a mix of no-deco plans and plans with increasing obligations */
+    for (int j = 0; j < NOF_PLANS; j++) {
+        depth[j] = abs_depth(NULL, msw_to_bar(18 + 4 * j));
+        gas[j] = j < 6 ? &air : &tmx;
+
+        init_decostate(&ds[j], &conf);
+        add_segment_ascdec(&ds[j], abs_depth(NULL, 0), depth[j], 3, gas[j]);
+        add_segment_const(&ds[j], depth[j], 10 + 3 * j, gas[j]);
+
+        batch_set_plan(&b, j, &ds[j]);
+    }
+
+    decoinfo_t ret[NOF_PLANS];
+    mu_check(batch_calc_deco(&b, depth, gas, deco_gasses, len(deco_gasses), ret) == 0);
+
+    for (int j = 0; j < NOF_PLANS; j++) {
+        decoinfo_t expected = calc_deco(&ds[j], depth[j], gas[j], deco_gasses, len(deco_gasses), NULL);
+
+        mu_assert_double_eq(expected.ndl, ret[j].ndl);
+        mu_check(expected.tts == ret[j].tts);
+
+        decostate_t ds_;
+        batch_get_plan(&b, j, &ds_);
+
+        for (int i = 0; i < 16; i++) {
+            mu_check(ds_.tissues.phe[i] == ds[j].tissues.phe[i]);
+            mu_check(ds_.tissues.pn2[i] == ds[j].tissues.pn2[i]);
+        }
+
+        mu_assert_double_eq(ds[j].firststop, ds_.firststop);
+    }
+
+    free_decostate_batch(&b);
+}
+
+void testsuite_batch_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+}
+
+void testsuite_batch_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_batch)
+{
+    MU_SUITE_CONFIGURE(&testsuite_batch_setup, &testsuite_batch_teardown);
+
+    MU_RUN_TEST(test_batch_segments);
+    MU_RUN_TEST(test_batch_calc_deco);
+}
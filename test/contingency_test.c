@@ -0,0 +1,208 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+
+#include "minunit/minunit.h"
+
+#include "src/contingency.h"
+#include "src/deco.h"
+#include "src/pool.h"
+#include "src/schedule.h"
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+/* the plan a user would get for the same dive, planned from scratch */
+static decoinfo_t plan_from_surface(const decoconf_t *c, double depth, double time, double extra, const gas_t *gas,
+                                    const gas_t *deco_gasses, int nof_gasses)
+{
+    const double descent_time = gauge_depth(NULL, depth) / msw_to_bar(9);
+
+    decostate_t ds;
+    init_decostate(&ds, c);
+    add_segment_ascdec(&ds, abs_depth(NULL, 0), depth, descent_time, gas);
+    add_segment_const(&ds, depth, time - descent_time, gas);
+
+    if (extra)
+        add_segment_const(&ds, depth, extra, gas);
+
+    return calc_deco(&ds, depth, gas, deco_gasses, nof_gasses, NULL);
+}
+
+MU_TEST(test_contingency_slate)
+{
+    const gas_t tmx = gas_new(NULL, 21, 35, MOD_AUTO);
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    const double depth = abs_depth(NULL, msw_to_bar(45));
+    const double deeper = depth + msw_to_bar(CONTINGENCY_DEEPER);
+
+    pool_t *pool = pool_new(3);
+    contingency_slate_t slate[2];
+
+    mu_check(contingency_slate(&slate[0], &conf, depth, 30, &tmx, deco_gasses, len(deco_gasses), NULL) == 0);
+    mu_check(contingency_slate(&slate[1], &conf, depth, 30, &tmx, deco_gasses, len(deco_gasses), pool) == 0);
+
+    /* plan, deeper, longer, both, two lost gasses and two higher gfs */
+    mu_check(slate[0].nof_variants == 8);
+    mu_check(slate[1].nof_variants == 8);
+
+    const contingency_t *v = slate[0].variants;
+
+    mu_check(v[0].type == CONTINGENCY_PLAN);
+    mu_check(v[4].type == CONTINGENCY_LOST_GAS && v[4].lost_gas == &deco_gasses[0]);
+    mu_check(v[7].type == CONTINGENCY_HIGHER_GF && v[7].conf.gfhi == conf.gfhi + 2 * CONTINGENCY_GF_STEP);
+
+    decoconf_t gf;
+    init_decoconf(&gf, ctx, conf.gflo, conf.gfhi + CONTINGENCY_GF_STEP, conf.ceil_multiple);
+
+    const decoinfo_t expected[] = {
+        plan_from_surface(&conf, depth, 30, 0, &tmx, deco_gasses, 2),
+        plan_from_surface(&conf, deeper, 30, 0, &tmx, deco_gasses, 2),
+        plan_from_surface(&conf, depth, 30, CONTINGENCY_LONGER, &tmx, deco_gasses, 2),
+        plan_from_surface(&conf, deeper, 30, CONTINGENCY_LONGER, &tmx, deco_gasses, 2),
+        plan_from_surface(&conf, depth, 30, 0, &tmx, &deco_gasses[1], 1),
+        plan_from_surface(&conf, depth, 30, 0, &tmx, deco_gasses, 1),
+        plan_from_surface(&gf, depth, 30, 0, &tmx, deco_gasses, 2),
+    };
+
+    for (int i = 0; i < (int) len(expected); i++)
+        mu_assert_double_eq(expected[i].tts, v[i].plan.info.tts);
+
+    /* more time at depth or a lost gas never shortens the ascent, a higher gf never lengthens it */
+    mu_check(v[1].plan.info.tts > v[0].plan.info.tts);
+    mu_check(v[3].plan.info.tts > v[2].plan.info.tts);
+    mu_check(v[4].plan.info.tts > v[0].plan.info.tts);
+    mu_check(v[6].plan.info.tts <= v[0].plan.info.tts);
+
+    /* the stops add up to the tts together with the travel between them */
+    double stops = 0;
+
+    for (int s = 0; s < v[0].plan.nof_stops; s++)
+        stops += v[0].plan.stops[s].time;
+
+    mu_check(v[0].plan.nof_stops > 0);
+    mu_check(stops < v[0].plan.info.tts);
+    mu_check(v[0].plan.info.tts - stops < gauge_depth(NULL, depth) / msw_to_bar(9) + 1E-9);
+
+    /* the pool only changes the order of evaluation */
+    for (int i = 0; i < slate[0].nof_variants; i++) {
+        mu_check(slate[0].variants[i].plan.info.tts == slate[1].variants[i].plan.info.tts);
+        mu_check(slate[0].variants[i].plan.nof_stops == slate[1].variants[i].plan.nof_stops);
+    }
+
+    free_contingency_slate(&slate[0]);
+    free_contingency_slate(&slate[1]);
+    pool_free(pool);
+}
+
+MU_TEST(test_contingency_slate_many_gasses)
+{
+    const gas_t tmx = gas_new(NULL, 18, 45, MOD_AUTO);
+    gas_t deco_gasses[GAS_SCHEDULE_GASSES + 2];
+
+    for (int i = 0; i < (int) len(deco_gasses); i++)
+        deco_gasses[i] = gas_new(NULL, 30 + 7 * i, 0, MOD_AUTO);
+
+    const double depth = abs_depth(NULL, msw_to_bar(45));
+    const int n = len(deco_gasses);
+
+    contingency_slate_t slate;
+    mu_check(contingency_slate(&slate, &conf, depth, 30, &tmx, deco_gasses, n, NULL) == 0);
+    mu_check(slate.nof_variants == 4 + n + 2);
+
+    /* every lost gas variant keeps the others in order */
+    for (int i = 0; i < n; i++) {
+        const contingency_t *v = &slate.variants[4 + i];
+
+        mu_check(v->type == CONTINGENCY_LOST_GAS && v->lost_gas == &deco_gasses[i]);
+        mu_check(v->nof_gasses == n - 1);
+
+        for (int j = 0; j < n - 1; j++)
+            mu_check(gas_equal(&v->deco_gasses[j], &deco_gasses[j < i ? j : j + 1]));
+
+        decoinfo_t expected = plan_from_surface(&conf, depth, 30, 0, &tmx, v->deco_gasses, n - 1);
+        mu_assert_double_eq(expected.tts, v->plan.info.tts);
+    }
+
+    mu_check(slate.variants[0].deco_gasses == deco_gasses);
+
+    free_contingency_slate(&slate);
+}
+
+MU_TEST(test_bailout_matrix)
+{
+    const gas_t tmx = gas_new(NULL, 15, 55, MOD_AUTO);
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 18, 45, MOD_AUTO),
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    const double depth = abs_depth(NULL, msw_to_bar(60));
+
+    pool_t *pool = pool_new(3);
+    bailout_matrix_t matrix[2];
+
+    mu_check(bailout_matrix(&matrix[0], &conf, depth, 25.5, &tmx, deco_gasses, len(deco_gasses), NULL) == 0);
+    mu_check(bailout_matrix(&matrix[1], &conf, depth, 25.5, &tmx, deco_gasses, len(deco_gasses), pool) == 0);
+
+    /* every whole minute from the first after a minute at depth */
+    mu_check(matrix[0].nof_bailouts == 18);
+    mu_check(matrix[0].bailouts[0].time == 8);
+    mu_check(matrix[0].bailouts[17].time == 25);
+
+    /* the checkpoints only differ from a dive planned from scratch by rounding */
+    double max_err = 0;
+
+    for (int i = 0; i < matrix[0].nof_bailouts; i++) {
+        const bailout_t *b = &matrix[0].bailouts[i];
+        decoinfo_t expected = plan_from_surface(&conf, depth, b->time, 0, &tmx, deco_gasses, len(deco_gasses));
+
+        max_err = max(max_err, fabs(expected.tts - b->plan.info.tts));
+
+        if (i)
+            mu_check(b->plan.info.tts >= matrix[0].bailouts[i - 1].plan.info.tts);
+    }
+
+    mu_assert_double_near(0, max_err, 1E-9);
+
+    /* the pool only changes the order of evaluation */
+    for (int i = 0; i < matrix[0].nof_bailouts; i++) {
+        mu_check(matrix[0].bailouts[i].plan.info.tts == matrix[1].bailouts[i].plan.info.tts);
+        mu_check(matrix[0].bailouts[i].plan.nof_stops == matrix[1].bailouts[i].plan.nof_stops);
+    }
+
+    free_bailout_matrix(&matrix[0]);
+    free_bailout_matrix(&matrix[1]);
+
+    /* dives shorter than the descent bail out once, at their runtime */
+    mu_check(bailout_matrix(&matrix[0], &conf, depth, 3, &tmx, deco_gasses, len(deco_gasses), NULL) == 0);
+    mu_check(matrix[0].nof_bailouts == 1 && matrix[0].bailouts[0].time == 3);
+    free_bailout_matrix(&matrix[0]);
+
+    pool_free(pool);
+}
+
+void testsuite_contingency_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 75, msw_to_bar(3));
+}
+
+void testsuite_contingency_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_contingency)
+{
+    MU_SUITE_CONFIGURE(&testsuite_contingency_setup, &testsuite_contingency_teardown);
+
+    MU_RUN_TEST(test_contingency_slate);
+    MU_RUN_TEST(test_contingency_slate_many_gasses);
+    MU_RUN_TEST(test_bailout_matrix);
+}
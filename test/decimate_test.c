@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "minunit/minunit.h"
+
+#include "src/decimate.h"
+#include "src/deco.h"
+#include "src/schedule.h"
+
+#define NOF_SAMPLES 7200 /* two hours of per second samples */
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+/* a per second log of a multilevel dive with some noise and a gas switch on the way up */
+static void dive_log(waypoint_t *wp, const gas_t *bottom_gas, const gas_t *deco_gas)
+{
+    for (int i = 0; i < NOF_SAMPLES; i++) {
+        double t = i / 60.0;
+        double m;
+
+        if (t < 3)
+            m = 10 * t;
+        else if (t < 40)
+            m = 30;
+        else if (t < 45)
+            m = 30 - 2 * (t - 40);
+        else if (t < 80)
+            m = 20;
+        else if (t < 85)
+            m = 20 - 3 * (t - 80);
+        else
+            m = max(0, 5 - (t - 85) / 7);
+
+        /* dive computers resolve 0.1m */
+        m = round((m + 0.05 * sin(i * 1.7)) * 10) / 10;
+
+        wp[i] = (waypoint_t){
+            .depth = abs_depth(NULL, msw_to_bar(m)),
+            .time = 1 / 60.0,
+            .gas = t < 85 ? bottom_gas : deco_gas,
+        };
+    }
+}
+
+MU_TEST(test_decimate_dive)
+{
+    const gas_t tx = gas_new(NULL, 21, 35, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+    const double tolerance = 0.01;
+
+    /* decostate_t embeds 64 byte aligned tissues */
+    decostate_t *expected;
+    mu_check(!posix_memalign((void **) &expected, 64, NOF_SAMPLES * sizeof(decostate_t)));
+
+    waypoint_t *wp = malloc(NOF_SAMPLES * sizeof(waypoint_t));
+    waypoint_t *out = malloc(NOF_SAMPLES * sizeof(waypoint_t));
+    double *runtime = malloc(NOF_SAMPLES * sizeof(double));
+
+    dive_log(wp, &tx, &ean50);
+
+    int n = decimate_dive(out, wp, NOF_SAMPLES, abs_depth(NULL, 0), tolerance);
+    mu_check(n > 0);
+    mu_check(NOF_SAMPLES / n >= 20);
+
+    /* the dive does not get longer or shorter and still ends at the same depth on the same gas */
+    double total = 0;
+
+    for (int i = 0; i < n; i++)
+        total += out[i].time;
+
+    mu_assert_double_near(NOF_SAMPLES / 60.0, total, 1E-9);
+    mu_assert_double_eq(wp[NOF_SAMPLES - 1].depth, out[n - 1].depth);
+
+    /* the gas switch survives */
+    int switches = 0;
+
+    for (int i = 1; i < n; i++)
+        switches += out[i].gas != out[i - 1].gas;
+
+    mu_check(switches == 1);
+
+    /* compartment pressures of the original dive at every sample, same segments as simulate_dive() */
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    double depth = abs_depth(NULL, 0);
+
+    for (int i = 0; i < NOF_SAMPLES; i++) {
+        if (wp[i].depth != depth)
+            add_segment_ascdec(&ds, depth, wp[i].depth, wp[i].time, wp[i].gas);
+        else
+            add_segment_const(&ds, depth, wp[i].time, wp[i].gas);
+
+        depth = wp[i].depth;
+        expected[i] = ds;
+        runtime[i] = (i + 1) / 60.0;
+    }
+
+    /* are within tolerance of the decimated dive wherever both have a waypoint */
+    decostate_t dec;
+    init_decostate(&dec, &conf);
+
+    depth = abs_depth(NULL, 0);
+    double time = 0;
+    double err = 0;
+    int j = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (out[i].depth != depth)
+            add_segment_ascdec(&dec, depth, out[i].depth, out[i].time, out[i].gas);
+        else
+            add_segment_const(&dec, depth, out[i].time, out[i].gas);
+
+        depth = out[i].depth;
+        time += out[i].time;
+
+        while (j < NOF_SAMPLES && runtime[j] < time - 1E-9)
+            j++;
+
+        for (int k = 0; k < 16; k++) {
+            err = max(err, fabs(dec.tissues.pn2[k] - expected[j].tissues.pn2[k]));
+            err = max(err, fabs(dec.tissues.phe[k] - expected[j].tissues.phe[k]));
+        }
+    }
+
+    mu_check(err <= tolerance);
+    mu_check(err > 0);
+
+    /* a tolerance of zero only merges samples on a straight line, which changes nothing */
+    int n0 = decimate_dive(out, wp, NOF_SAMPLES, abs_depth(NULL, 0), 0);
+    mu_check(n0 > n && n0 < NOF_SAMPLES);
+
+    init_decostate(&dec, &conf);
+    simulate_dive(&dec, out, n0, NULL);
+
+    for (int k = 0; k < 16; k++) {
+        mu_assert_double_near(expected[NOF_SAMPLES - 1].tissues.pn2[k], dec.tissues.pn2[k], 1E-9);
+        mu_assert_double_near(expected[NOF_SAMPLES - 1].tissues.phe[k], dec.tissues.phe[k], 1E-9);
+    }
+
+    /* in place */
+    mu_check(decimate_dive(wp, wp, NOF_SAMPLES, abs_depth(NULL, 0), tolerance) == n);
+
+    free(wp);
+    free(out);
+    free(expected);
+    free(runtime);
+}
+
+void testsuite_decimate_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+}
+
+void testsuite_decimate_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_decimate)
+{
+    MU_SUITE_CONFIGURE(&testsuite_decimate_setup, &testsuite_decimate_teardown);
+
+    MU_RUN_TEST(test_decimate_dive);
+}
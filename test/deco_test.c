@@ -1,8 +1,11 @@
 /* SPDX-License-Identifier: MIT-0 */
 
+#include <math.h>
+
 #include "minunit/minunit.h"
 
 #include "src/deco.h"
+#include "src/kernel.h"
 
 MU_TEST(test_bar_to_msw)
 {
@@ -16,17 +19,17 @@ MU_TEST(test_msw_to_bar)
 
 MU_TEST(test_abs_gauge)
 {
-    mu_assert_double_eq(1, abs_depth(gauge_depth(1)));
+    mu_assert_double_eq(1, abs_depth(NULL, gauge_depth(NULL, 1)));
 }
 
 MU_TEST(test_gas)
 {
     double max_mod_err = 1E-3;
 
-    gas_t foo = gas_new(21, 35, MOD_AUTO);
-    gas_t bar = gas_new(21, 0, MOD_AUTO);
-    gas_t baz = gas_new(21, 35, MOD_AUTO);
-    gas_t qux = gas_new(21, 35, 99);
+    gas_t foo = gas_new(NULL, 21, 35, MOD_AUTO);
+    gas_t bar = gas_new(NULL, 21, 0, MOD_AUTO);
+    gas_t baz = gas_new(NULL, 21, 35, MOD_AUTO);
+    gas_t qux = gas_new(NULL, 21, 35, 99);
 
     mu_assert_int_eq(21, gas_o2(&foo));
     mu_assert_int_eq(35, gas_he(&foo));
@@ -37,11 +40,262 @@ MU_TEST(test_gas)
     mu_check(gas_equal(&foo, &baz));
     mu_check(!gas_equal(&foo, &qux));
 
-    mu_assert_double_near(abs_depth(msw_to_bar(51.6)), gas_mod(&foo), max_mod_err);
-    mu_assert_double_near(abs_depth(msw_to_bar(30)), gas_mod(&bar), max_mod_err);
+    mu_assert_double_near(abs_depth(NULL, msw_to_bar(51.6)), gas_mod(&foo), max_mod_err);
+    mu_assert_double_near(abs_depth(NULL, msw_to_bar(30)), gas_mod(&bar), max_mod_err);
     mu_assert_double_near(99, gas_mod(&qux), max_mod_err);
 }
 
+MU_TEST(test_context)
+{
+    opendeco_ctx *ctx = opendeco_ctx_new(ZHL_16B, P_WV_NAVY);
+    mu_check(ctx);
+
+    opendeco_ctx_set_surface_pressure(ctx, 0.8);
+    opendeco_ctx_set_po2_max(ctx, 1.4);
+
+    gas_t ean50 = gas_new(ctx, 50, 0, MOD_AUTO);
+
+    mu_assert_int_eq(ZHL_16B, opendeco_ctx_model(ctx)->algo);
+    mu_assert_double_eq(0.8, abs_depth(ctx, 0));
+    mu_assert_double_eq(1.4 / 0.5, gas_mod(&ean50));
+
+    /* the default context follows the globals, other contexts are unaffected */
+    SURFACE_PRESSURE = 0.9;
+
+    mu_assert_double_eq(0.9, abs_depth(NULL, 0));
+    mu_assert_double_eq(0.8, abs_depth(ctx, 0));
+
+    SURFACE_PRESSURE = SURFACE_PRESSURE_DEFAULT;
+
+    /* its model is built once and never moves */
+    const model_t *model = opendeco_ctx_model(NULL);
+
+    mu_assert_int_eq(ALGO_VER_DEFAULT, model->algo);
+    mu_assert_double_eq(P_WV_DEFAULT, model->p_wv);
+    mu_check(model == opendeco_ctx_model(NULL));
+
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST(test_model)
+{
+    model_t zhl16a;
+    model_t zhl16c;
+
+    model_init(&zhl16a, ZHL_16A, P_WV_BUHL);
+    model_init(&zhl16c, ZHL_16C, P_WV_SCHR);
+
+    mu_assert_double_near(log(2) / 5.0, zhl16c.n2_k[0], 1E-12);
+    mu_assert_double_near(log(2) / 1.88, zhl16c.he_k[0], 1E-12);
+
+    for (int i = 0; i < 16; i++) {
+        mu_assert_double_near(1, zhl16c.n2_k[i] * zhl16c.n2_kinv[i], 1E-12);
+        mu_assert_double_near(1, zhl16c.he_k[i] * zhl16c.he_kinv[i], 1E-12);
+    }
+
+    mu_assert_double_eq(0.6667, zhl16a.n2_a[4]);
+    mu_assert_double_eq(0.6200, zhl16c.n2_a[4]);
+    mu_assert_double_eq(P_WV_SCHR, zhl16c.p_wv);
+}
+
+MU_TEST(test_kernels)
+{
+    const double max_err = 1E-12;
+    const enum KERNEL previous = kernel_active();
+
+    model_t model;
+    model_init(&model, ZHL_16C, P_WV_BUHL);
+
+    for (enum KERNEL kernel = KERNEL_SSE2; kernel <= KERNEL_AVX2; kernel++) {
+        tissues_t t[2];
+
+        for (int i = 0; i < 16; i++) {
+            t[0].phe[i] = t[1].phe[i] = 0.05 * i;
+            t[0].pn2[i] = t[1].pn2[i] = 0.75 + 0.1 * i;
+        }
+
+        t[0].he_loaded = t[1].he_loaded = 1;
+
+        propagator_t p[2][2];
+
+        kernel_select(KERNEL_SCALAR);
+        kernel_propagate(&p[0][0], &model, 7.5);
+        kernel_propagate(&p[0][1], &model, 33.0);
+        kernel_segment_ascdec(&t[0], &model, &p[0][0], 5.0, 3.0, -0.3, -0.2, 7.5);
+        kernel_segment_const(&t[0], &p[0][1], 1.2, 2.4);
+
+        if (kernel_select(kernel) != kernel)
+            continue;
+
+        kernel_propagate(&p[1][0], &model, 7.5);
+        kernel_propagate(&p[1][1], &model, 33.0);
+        kernel_segment_ascdec(&t[1], &model, &p[1][0], 5.0, 3.0, -0.3, -0.2, 7.5);
+        kernel_segment_const(&t[1], &p[1][1], 1.2, 2.4);
+
+        for (int i = 0; i < 16; i++) {
+            mu_assert_double_near(t[0].phe[i], t[1].phe[i], max_err);
+            mu_assert_double_near(t[0].pn2[i], t[1].pn2[i], max_err);
+        }
+
+        /* ceiling and gf99 reductions must be bit-identical */
+        for (double gf = 0.3; gf <= 1.0; gf += 0.1) {
+            kernel_select(KERNEL_SCALAR);
+            double c = kernel_ceiling(&t[0], &model, gf);
+            double g = kernel_gf99(&t[0], &model, abs_depth(NULL, gf));
+
+            kernel_select(kernel);
+            mu_check(c == kernel_ceiling(&t[0], &model, gf));
+            mu_check(g == kernel_gf99(&t[0], &model, abs_depth(NULL, gf)));
+        }
+    }
+
+    kernel_select(previous);
+}
+
+MU_TEST(test_ceilings)
+{
+    const enum KERNEL previous = kernel_active();
+
+    model_t model;
+    model_init(&model, ZHL_16C, P_WV_BUHL);
+
+    tissues_t t;
+
+    for (int i = 0; i < 16; i++) {
+        t.phe[i] = 0.05 * i;
+        t.pn2[i] = 0.75 + 0.1 * i;
+    }
+
+    /* more gradient factors than fit a single pass */
+    double gf[40];
+    double c[len(gf)];
+
+    for (int j = 0; j < (int) len(gf); j++)
+        gf[j] = 10 + 2.5 * j;
+
+    for (enum KERNEL kernel = KERNEL_SCALAR; kernel <= KERNEL_AVX2; kernel++) {
+        if (kernel_select(kernel) != kernel)
+            continue;
+
+        for (t.he_loaded = 0; t.he_loaded <= 1; t.he_loaded++) {
+            tissues_ceilings(&t, &model, gf, len(gf), c);
+
+            for (int j = 0; j < (int) len(gf); j++)
+                mu_check(c[j] == tissues_ceiling(&t, &model, gf[j]));
+        }
+    }
+
+    kernel_select(previous);
+}
+
+MU_TEST(test_gas_classes)
+{
+    const double max_err = 1E-12;
+    const enum KERNEL previous = kernel_active();
+
+    model_t model;
+    model_init(&model, ZHL_16C, P_WV_BUHL);
+
+    propagator_t p;
+    kernel_propagate(&p, &model, 12.5);
+
+    for (enum KERNEL kernel = KERNEL_SCALAR; kernel <= KERNEL_AVX2; kernel++) {
+        if (kernel_select(kernel) != kernel)
+            continue;
+
+        tissues_t n2, tmx;
+        init_tissues(&n2, NULL);
+
+        /* a helium flag forces the trimix kernels onto the same nitrox segments */
+        tmx = n2;
+        tmx.he_loaded = 1;
+
+        kernel_segment_ascdec(&n2, &model, &p, 0, 3.0, 0, 0.2, 12.5);
+        kernel_segment_const(&n2, &p, 0, 4.1);
+        kernel_segment_ascdec(&tmx, &model, &p, 0, 3.0, 0, 0.2, 12.5);
+        kernel_segment_const(&tmx, &p, 0, 4.1);
+
+        mu_check(!n2.he_loaded);
+
+        for (int i = 0; i < 16; i++) {
+            mu_check(n2.phe[i] == 0);
+            mu_check(n2.pn2[i] == tmx.pn2[i]);
+        }
+
+        mu_assert_double_near(kernel_ceiling(&tmx, &model, 0.5), kernel_ceiling(&n2, &model, 0.5), max_err);
+        mu_assert_double_near(kernel_gf99(&tmx, &model, 1.2), kernel_gf99(&n2, &model, 1.2), max_err);
+
+        /* helium sticks to the tissues, oxygen leaves the nitrogen to off-gas */
+        kernel_segment_const(&n2, &p, 2.0, 1.5);
+        mu_check(n2.he_loaded);
+
+        tissues_t hx = n2;
+        kernel_segment_const(&hx, &p, 0, 0);
+        kernel_segment_ascdec(&hx, &model, &p, 0, 0, 0, 0, 12.5);
+
+        for (int i = 0; i < 16; i++) {
+            double pn2 = n2.pn2[i] + (0 - n2.pn2[i]) * (1 - p.n2_e[i]);
+            double phe = n2.phe[i] + (0 - n2.phe[i]) * (1 - p.he_e[i]);
+
+            mu_check(pn2 * p.n2_e[i] == hx.pn2[i]);
+            mu_assert_double_near(phe * p.he_e[i], hx.phe[i], max_err);
+        }
+    }
+
+    kernel_select(previous);
+}
+
+MU_TEST(test_propagator_cache)
+{
+    model_t model;
+    model_init(&model, ZHL_16C, P_WV_BUHL);
+
+    propagator_t scratch;
+
+    /* whole minutes are served from the model, anything else is computed into scratch */
+    const propagator_t *p1 = model_propagator(&model, 1, &scratch);
+
+    mu_check(p1 == &model.minutes[0]);
+    mu_check(&model.minutes[9] == model_propagator(&model, 10, &scratch));
+    mu_check(&model.minutes[MODEL_MINUTES - 1] == model_propagator(&model, MODEL_MINUTES, &scratch));
+    mu_assert_double_near(exp(-model.n2_k[3] * 7), model_propagator(&model, 7, &scratch)->n2_e[3], 1E-12);
+
+    mu_check(&scratch == model_propagator(&model, 7.5, &scratch));
+    mu_assert_double_near(exp(-model.n2_k[3] * 7.5), scratch.n2_e[3], 1E-12);
+    mu_check(&scratch == model_propagator(&model, MODEL_MINUTES + 1, &scratch));
+
+    /* the ascent between any two stops hits the propagator of the plan config */
+    decoconf_t c;
+    init_decoconf(&c, NULL, 30, 70, msw_to_bar(3));
+
+    double next_stop = abs_depth(NULL, msw_to_bar(120));
+    int hits = 0;
+
+    for (double depth = next_stop; next_stop > abs_depth(NULL, msw_to_bar(3)); depth = next_stop) {
+        next_stop -= c.ceil_multiple;
+
+        double time = decoconf_ascent_time(&c, depth, next_stop);
+
+        mu_assert_double_near(fabs(depth - next_stop) / msw_to_bar(9), time, 1E-12);
+        hits += decoconf_propagator(&c, time, &scratch) == &c.stop_ascent;
+    }
+
+    mu_check(hits == 39);
+    mu_check(&c.model->minutes[0] == decoconf_propagator(&c, 1, &scratch));
+
+    /* nor are propagators of a kernel that is no longer selected */
+    const enum KERNEL previous = kernel_active();
+
+    if (kernel_select(KERNEL_SCALAR) != previous) {
+        mu_check(&scratch == model_propagator(&model, 1, &scratch));
+        mu_check(&scratch == decoconf_propagator(&c, c.stop_ascent.time, &scratch));
+        mu_check(scratch.kernel == KERNEL_SCALAR);
+    }
+
+    kernel_select(previous);
+    mu_check(p1 == model_propagator(&model, 1, &scratch));
+}
+
 void testsuite_deco_setup(void)
 {
 }
@@ -58,4 +312,10 @@ MU_TEST_SUITE(testsuite_deco)
     MU_RUN_TEST(test_msw_to_bar);
     MU_RUN_TEST(test_abs_gauge);
     MU_RUN_TEST(test_gas);
+    MU_RUN_TEST(test_context);
+    MU_RUN_TEST(test_model);
+    MU_RUN_TEST(test_kernels);
+    MU_RUN_TEST(test_ceilings);
+    MU_RUN_TEST(test_gas_classes);
+    MU_RUN_TEST(test_propagator_cache);
 }
@@ -0,0 +1,282 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/divelog.h"
+#include "src/pool.h"
+
+#define NOF_SAMPLES 100000
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+typedef struct last_t {
+    log_sample_t sample;
+    gas_t gas; /* sample.gas only lives during the callback */
+    double max_gf99;
+    int n;
+} last_t;
+
+static void keep_last(const decostate_t *ds, const log_sample_t *sample, void *arg)
+{
+    last_t *last = arg;
+
+    last->sample = *sample;
+    last->gas = *sample->gas;
+    last->max_gf99 = max(last->max_gf99, sample->gf99);
+    last->n++;
+}
+
+static int replay_str(decostate_t *ds, const char *csv, const gas_t *gas, last_t *last, int *line)
+{
+    FILE *file = fmemopen((void *) csv, strlen(csv), "r");
+    divelog_t log;
+
+    if (!file || init_divelog(&log, file, ctx, gas))
+        return -2;
+
+    log_callback_t cb = {.fn = &keep_last, .arg = last};
+    int ret = replay_log(ds, &log, &cb, NULL);
+
+    if (line)
+        *line = log.line;
+
+    free_divelog(&log);
+    fclose(file);
+
+    return ret;
+}
+
+MU_TEST(test_replay_log)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+
+    const char *csv = "time,depth,gas\n"
+                      "0,0\n"
+                      "60,10\n"
+                      "# a comment\n"
+                      "\n"
+                      "2:00, 20\n"
+                      "20:00,20,\n"
+                      "22:00,12,EAN50\n"
+                      "25:00,3\n"
+                      "28:00,0";
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    last_t last = {0};
+    mu_check(replay_str(&ds, csv, &air, &last, NULL) == 7);
+    mu_check(last.n == 7);
+
+    /* the same profile as segments, every segment on the gas of the sample it starts at */
+    const double surface = abs_depth(NULL, 0);
+    const double d10 = abs_depth(NULL, msw_to_bar(10));
+    const double d20 = abs_depth(NULL, msw_to_bar(20));
+    const double d12 = abs_depth(NULL, msw_to_bar(12));
+    const double d3 = abs_depth(NULL, msw_to_bar(3));
+
+    decostate_t expected;
+    init_decostate(&expected, &conf);
+    add_segment_ascdec(&expected, surface, d10, 1, &air);
+    add_segment_ascdec(&expected, d10, d20, 1, &air);
+    add_segment_const(&expected, d20, 18, &air);
+    add_segment_ascdec(&expected, d20, d12, 2, &air);
+    add_segment_ascdec(&expected, d12, d3, 3, &ean50);
+    add_segment_ascdec(&expected, d3, surface, 3, &ean50);
+
+    for (int i = 0; i < 16; i++) {
+        mu_assert_double_near(expected.tissues.pn2[i], ds.tissues.pn2[i], 1E-12);
+        mu_assert_double_near(expected.tissues.phe[i], ds.tissues.phe[i], 1E-12);
+    }
+
+    mu_assert_double_eq(28, last.sample.time);
+    mu_assert_double_eq(surface, last.sample.depth);
+    mu_check(gas_o2(&last.gas) == 50 && gas_he(&last.gas) == 0);
+    mu_assert_double_near(ceiling(&expected, conf.gfhi), last.sample.ceiling, 1E-12);
+    mu_assert_double_near(gf99(&expected, surface), last.sample.gf99, 1E-9);
+    mu_assert_double_eq(last.sample.gf99, last.sample.surf_gf);
+    mu_check(last.sample.compartment >= 0 && last.sample.compartment < 16);
+}
+
+MU_TEST(test_replay_log_invalid)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    const char *invalid[] = {
+        "0,0\n60,10\n30,10\n", /* time runs backwards */
+        "0,0\n60,-1\n",        /* negative depth */
+        "0,0\n60\n",           /* missing depth */
+        "0,0\n1:75,10\n",      /* seconds out of range */
+        "0,0\n60,10,Foo\n",    /* unknown gas */
+        "0,0\n60,10,60/50\n",  /* more than 100% */
+        "0,0\n60,10,EAN300\n", /* oxygen out of range */
+        "0,0\n60,10,0/30\n",   /* no oxygen */
+        "0,0\n60,10,21/35x\n", /* trailing garbage */
+    };
+
+    const int lines[] = {3, 2, 2, 2, 2, 2, 2, 2, 2};
+
+    for (int i = 0; i < (int) len(invalid); i++) {
+        decostate_t ds;
+        init_decostate(&ds, &conf);
+
+        last_t last = {0};
+        int line;
+
+        mu_check(replay_str(&ds, invalid[i], &air, &last, &line) == -1);
+        mu_check(line == lines[i]);
+    }
+}
+
+MU_TEST(test_replay_log_long)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    /* per second samples of a wavy profile, many times the size of the read buffer */
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    for (int i = 0; i < NOF_SAMPLES; i++)
+        fprintf(file, "%i,%.2f\n", i, 10 + 5 * sin(i / 600.0));
+
+    rewind(file);
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    divelog_t log;
+    mu_check(init_divelog(&log, file, ctx, &air) == 0);
+
+    last_t last = {0};
+    log_callback_t cb = {.fn = &keep_last, .arg = &last};
+
+    mu_check(replay_log(&ds, &log, &cb, NULL) == NOF_SAMPLES);
+    mu_check(last.n == NOF_SAMPLES);
+    mu_check(log.line == NOF_SAMPLES);
+    mu_assert_double_eq((NOF_SAMPLES - 1) / 60.0, last.sample.time);
+    mu_check(last.max_gf99 > 0);
+
+    free_divelog(&log);
+    fclose(file);
+}
+
+MU_TEST(test_replay_log_decimated)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const double tolerance = 0.01;
+
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    for (int i = 0; i < NOF_SAMPLES; i++)
+        fprintf(file, "%i,%.1f\n", i, 10 + 5 * sin(i / 600.0));
+
+    decostate_t ds[2];
+    int nof_segments[2];
+
+    /* every sample, then decimated across several chunks */
+    for (int d = 0; d < 2; d++) {
+        rewind(file);
+        init_decostate(&ds[d], &conf);
+
+        divelog_t log;
+        mu_check(init_divelog(&log, file, ctx, &air) == 0);
+        log.tolerance = d ? tolerance : 0;
+
+        last_t last = {0};
+        log_callback_t cb = {.fn = &keep_last, .arg = &last};
+
+        mu_check(replay_log(&ds[d], &log, &cb, NULL) == NOF_SAMPLES);
+        mu_check(last.n == log.nof_segments + 1); /* the first sample is at time 0 */
+        mu_assert_double_near((NOF_SAMPLES - 1) / 60.0, last.sample.time, 1E-9);
+
+        nof_segments[d] = log.nof_segments;
+        free_divelog(&log);
+    }
+
+    mu_check(nof_segments[0] == NOF_SAMPLES - 1);
+    mu_check(nof_segments[1] * 20 < nof_segments[0]);
+
+    for (int k = 0; k < 16; k++)
+        mu_check(fabs(ds[0].tissues.pn2[k] - ds[1].tissues.pn2[k]) <= tolerance);
+
+    fclose(file);
+}
+
+MU_TEST(test_replay_log_pooled)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    pool_t *pool = pool_new(4);
+    mu_check(pool != NULL);
+
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+
+    /* jumps without time every so often and a gas switch halfway */
+    for (int i = 0; i < NOF_SAMPLES; i++)
+        fprintf(file, "%i,%.2f%s\n", i - i / 1000, 10 + 5 * sin(i / 600.0), i == NOF_SAMPLES / 2 ? ",EAN50" : "");
+
+    decostate_t ds[2];
+    last_t last[2] = {0};
+    int nof_segments[2];
+
+    /* in order, then in chunks on the pool */
+    for (int p = 0; p < 2; p++) {
+        rewind(file);
+        init_decostate(&ds[p], &conf);
+
+        divelog_t log;
+        mu_check(init_divelog(&log, file, ctx, &air) == 0);
+
+        log_callback_t cb = {.fn = &keep_last, .arg = &last[p]};
+
+        mu_check(replay_log(&ds[p], &log, &cb, p ? pool : NULL) == NOF_SAMPLES);
+
+        nof_segments[p] = log.nof_segments;
+        free_divelog(&log);
+    }
+
+    mu_check(last[1].n == NOF_SAMPLES);
+    mu_check(nof_segments[1] == nof_segments[0]);
+    mu_check(last[1].gas.o2 == 50);
+    mu_assert_double_near(last[0].sample.time, last[1].sample.time, 1E-9);
+    mu_assert_double_near(last[0].sample.ceiling, last[1].sample.ceiling, 1E-9);
+    mu_assert_double_near(last[0].max_gf99, last[1].max_gf99, 1E-9);
+    mu_check(last[1].sample.compartment == last[0].sample.compartment);
+
+    for (int k = 0; k < 16; k++)
+        mu_assert_double_near(ds[0].tissues.pn2[k], ds[1].tissues.pn2[k], 1E-9);
+
+    fclose(file);
+    pool_free(pool);
+}
+
+void testsuite_divelog_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+}
+
+void testsuite_divelog_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_divelog)
+{
+    MU_SUITE_CONFIGURE(&testsuite_divelog_setup, &testsuite_divelog_teardown);
+
+    MU_RUN_TEST(test_replay_log);
+    MU_RUN_TEST(test_replay_log_invalid);
+    MU_RUN_TEST(test_replay_log_long);
+    MU_RUN_TEST(test_replay_log_decimated);
+    MU_RUN_TEST(test_replay_log_pooled);
+}
@@ -2,11 +2,33 @@
 
 #include "minunit/minunit.h"
 
+MU_TEST_SUITE(testsuite_archive);
+MU_TEST_SUITE(testsuite_batch);
+MU_TEST_SUITE(testsuite_contingency);
 MU_TEST_SUITE(testsuite_deco);
+MU_TEST_SUITE(testsuite_decimate);
+MU_TEST_SUITE(testsuite_divelog);
+MU_TEST_SUITE(testsuite_optimize);
+MU_TEST_SUITE(testsuite_profile);
+MU_TEST_SUITE(testsuite_replay);
+MU_TEST_SUITE(testsuite_schedule);
+MU_TEST_SUITE(testsuite_sweep);
+MU_TEST_SUITE(testsuite_table);
 
 int main(int argc, const char *argv[])
 {
+    MU_RUN_SUITE(testsuite_archive);
+    MU_RUN_SUITE(testsuite_batch);
+    MU_RUN_SUITE(testsuite_contingency);
     MU_RUN_SUITE(testsuite_deco);
+    MU_RUN_SUITE(testsuite_decimate);
+    MU_RUN_SUITE(testsuite_divelog);
+    MU_RUN_SUITE(testsuite_optimize);
+    MU_RUN_SUITE(testsuite_profile);
+    MU_RUN_SUITE(testsuite_replay);
+    MU_RUN_SUITE(testsuite_schedule);
+    MU_RUN_SUITE(testsuite_sweep);
+    MU_RUN_SUITE(testsuite_table);
     MU_REPORT();
 
     return MU_EXIT_CODE;
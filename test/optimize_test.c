@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/optimize.h"
+#include "src/pool.h"
+#include "src/schedule.h"
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+MU_TEST(test_optimize_deco_gasses)
+{
+    const gas_t tmx = gas_new(NULL, 15, 55, MOD_AUTO);
+    const gas_t candidates[] = {
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+        gas_new(NULL, 80, 0, MOD_AUTO),
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 32, 0, MOD_AUTO),
+        gas_new(NULL, 21, 35, MOD_AUTO),
+    };
+
+    const double depth = abs_depth(NULL, msw_to_bar(60));
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+    add_segment_ascdec(&ds, abs_depth(NULL, 0), depth, gauge_depth(NULL, depth) / msw_to_bar(9), &tmx);
+    add_segment_const(&ds, depth, 20, &tmx);
+
+    pool_t *pool = pool_new(3);
+    gas_optimizer_t opt[3];
+
+    mu_check(optimize_deco_gasses(&opt[0], &ds, depth, &tmx, candidates, 5, 3, OBJECTIVE_TTS, 15, NULL) == 0);
+    mu_check(optimize_deco_gasses(&opt[1], &ds, depth, &tmx, candidates, 5, 3, OBJECTIVE_TTS, 15, pool) == 0);
+    mu_check(optimize_deco_gasses(&opt[2], &ds, depth, &tmx, candidates, 5, 3, OBJECTIVE_GAS, 15, pool) == 0);
+
+    /* 10 three gas, 10 two gas and 5 single gas sets */
+    mu_check(opt[0].nof_sets == 25);
+    mu_check(opt[0].sets[0].nof_gasses == 3 && opt[0].sets[24].nof_gasses == 1);
+
+    /* the best set matches the shortest ascent over all sets */
+    double best_tts = INFINITY;
+    int pruned = 0;
+
+    for (int i = 0; i < opt[0].nof_sets; i++) {
+        const gas_set_t *set = &opt[0].sets[i];
+        gas_t gasses[OPTIMIZER_GASSES];
+
+        for (int j = 0; j < set->nof_gasses; j++)
+            gasses[j] = candidates[set->gasses[j]];
+
+        decostate_t expected = ds;
+        double tts = calc_deco(&expected, depth, &tmx, gasses, set->nof_gasses, NULL).tts;
+
+        best_tts = min(best_tts, tts);
+        pruned += set->pruned;
+
+        if (!set->pruned)
+            mu_check(set->info.tts == tts);
+    }
+
+    mu_check(opt[0].best >= 0);
+    mu_check(opt[0].sets[opt[0].best].info.tts == best_tts);
+    mu_check(pruned > 0);
+
+    /* pruning does not depend on the order of evaluation, the result does not either */
+    mu_check(opt[1].best == opt[0].best);
+
+    /* the least gas never uses more than the shortest ascent, and nothing is pruned */
+    mu_check(opt[2].sets[opt[2].best].volume <= opt[0].sets[opt[0].best].volume);
+
+    for (int i = 0; i < opt[2].nof_sets; i++)
+        mu_check(!opt[2].sets[i].pruned);
+
+    for (int i = 0; i < (int) len(opt); i++)
+        free_gas_optimizer(&opt[i]);
+
+    pool_free(pool);
+}
+
+MU_TEST(test_optimize_blend)
+{
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 21, 35, MOD_AUTO),
+    };
+
+    const double depth = abs_depth(NULL, msw_to_bar(70));
+    const double descent_time = gauge_depth(NULL, depth) / msw_to_bar(9);
+
+    const waypoint_t waypoints[] = {
+        {.depth = depth, .time = descent_time,      .gas = NULL},
+        {.depth = depth, .time = 20 - descent_time, .gas = NULL},
+    };
+
+    pool_t *pool = pool_new(3);
+    blend_optimizer_t opt[2];
+
+    mu_check(optimize_blend(&opt[0], &conf, waypoints, 2, deco_gasses, 3, OBJECTIVE_TTS, 15, NULL) == 0);
+    mu_check(optimize_blend(&opt[1], &conf, waypoints, 2, deco_gasses, 3, OBJECTIVE_TTS, 15, pool) == 0);
+
+    /* every mix of whole percentages is either evaluated or ruled out */
+    mu_check(opt[0].nof_blends + opt[0].nof_infeasible == 5050);
+
+    /* the shared dive phase matches simulating it on the blend, the best blend the shortest ascent */
+    double max_err = 0;
+    double best_tts = INFINITY;
+
+    for (int i = 0; i < opt[0].nof_blends; i++) {
+        const gas_t *gas = &opt[0].blends[i].gas;
+
+        mu_check(gas_mod(gas) >= depth);
+
+        waypoint_t wp[] = {waypoints[0], waypoints[1]};
+        wp[0].gas = wp[1].gas = gas;
+
+        decostate_t expected, blended;
+        init_decostate(&expected, &conf);
+        simulate_dive(&expected, wp, 2, NULL);
+        blend_decostate(&blended, &opt[0], gas);
+
+        for (int j = 0; j < 16; j++) {
+            max_err = max(max_err, fabs(expected.tissues.pn2[j] - blended.tissues.pn2[j]));
+            max_err = max(max_err, fabs(expected.tissues.phe[j] - blended.tissues.phe[j]));
+        }
+
+        double tts = calc_deco(&expected, depth, gas, deco_gasses, 3, NULL).tts;
+        best_tts = min(best_tts, tts);
+    }
+
+    mu_assert_double_near(0, max_err, 1E-12);
+
+    mu_check(opt[0].best >= 0);
+    mu_assert_double_near(best_tts, opt[0].blends[opt[0].best].info.tts, 1E-9);
+    mu_check(gas_o2(&opt[0].blends[opt[0].best].gas) == 19);
+
+    /* the result does not depend on the order of evaluation */
+    mu_check(opt[1].best == opt[0].best);
+
+    free_blend_optimizer(&opt[0]);
+    free_blend_optimizer(&opt[1]);
+
+    pool_free(pool);
+}
+
+void testsuite_optimize_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 75, msw_to_bar(3));
+}
+
+void testsuite_optimize_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_optimize)
+{
+    MU_SUITE_CONFIGURE(&testsuite_optimize_setup, &testsuite_optimize_teardown);
+
+    MU_RUN_TEST(test_optimize_deco_gasses);
+    MU_RUN_TEST(test_optimize_blend);
+}
@@ -0,0 +1,388 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "minunit/minunit.h"
+
+#include "src/archive.h"
+#include "src/deco.h"
+#include "src/divelog.h"
+#include "src/pool.h"
+#include "src/profile.h"
+#include "src/schedule.h"
+
+#define NOF_WAYPOINTS 3600
+#define NOF_DIVES 12
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+static char path[64];
+
+typedef struct gas_check_t {
+    const gas_table_t *t;
+    int n;
+    int foreign; /* callbacks with a gas from outside the table */
+} gas_check_t;
+
+static void check_gas(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    gas_check_t *check = arg;
+
+    check->n++;
+    check->foreign += wp.gas < &check->t->gasses[0] || wp.gas >= &check->t->gasses[check->t->nof_gasses];
+}
+
+MU_TEST(test_gas_table)
+{
+    static gas_table_t t;
+    init_gas_table(&t);
+
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t air_ = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+
+    /* equal gasses share an id, whatever their address */
+    mu_check(gas_table_intern(&t, &air) == 0);
+    mu_check(gas_table_intern(&t, &ean50) == 1);
+    mu_check(gas_table_intern(&t, &air_) == 0);
+    mu_check(t.nof_gasses == 2);
+    mu_check(gas_equal(gas_table_gas(&t, 1), &ean50));
+
+    /* one id per gas until the table is full */
+    for (int o2 = 1; o2 <= 100; o2++) {
+        for (int he = 0; he <= 100 - o2; he += 5) {
+            gas_t gas = gas_new(NULL, o2, he, MOD_AUTO);
+            int id = gas_table_intern(&t, &gas);
+
+            if (t.nof_gasses < GAS_TABLE_GASSES)
+                mu_check(id >= 0);
+        }
+    }
+
+    gas_t gas = gas_new(NULL, 42, 42, 1);
+    mu_check(gas_table_intern(&t, &gas) == -1);
+    mu_check(t.nof_gasses == GAS_TABLE_GASSES);
+}
+
+MU_TEST(test_simulate_dive_packed)
+{
+    const gas_t tx = gas_new(NULL, 18, 45, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+    const gas_t oxygen = gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6)));
+
+    waypoint_t *waypoints = malloc(NOF_WAYPOINTS * sizeof(waypoint_t));
+    packed_waypoint_t *packed = malloc(NOF_WAYPOINTS * sizeof(packed_waypoint_t));
+
+    mu_check(sizeof(packed_waypoint_t) * 2 < sizeof(waypoint_t));
+
+    /* an hour of per second waypoints down to 60m and back on three gasses */
+    for (int i = 0; i < NOF_WAYPOINTS; i++) {
+        double m = 60 * sin(M_PI * i / NOF_WAYPOINTS);
+
+        waypoints[i] = (waypoint_t){
+            .depth = abs_depth(NULL, msw_to_bar(m)),
+            .time = 1 / 60.0,
+            .gas = m > 21 ? &tx : m > 6 ? &ean50 : &oxygen,
+        };
+    }
+
+    gas_table_t t;
+    init_gas_table(&t);
+
+    mu_check(pack_waypoints(packed, &t, waypoints, NOF_WAYPOINTS) == 0);
+    mu_check(t.nof_gasses == 3);
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+    simulate_dive(&ds, waypoints, NOF_WAYPOINTS, NULL);
+
+    decostate_t ds_packed;
+    init_decostate(&ds_packed, &conf);
+
+    gas_check_t check = {.t = &t};
+    waypoint_callback_t cb = {.fn = &check_gas, .arg = &check};
+
+    simulate_dive_packed(&ds_packed, &t, packed, NOF_WAYPOINTS, &cb);
+
+    mu_check(check.n == NOF_WAYPOINTS);
+    mu_check(check.foreign == 0);
+
+    /* only differs by the single precision depths and times */
+    for (int i = 0; i < 16; i++) {
+        mu_assert_double_near(ds.tissues.pn2[i], ds_packed.tissues.pn2[i], 1E-5);
+        mu_assert_double_near(ds.tissues.phe[i], ds_packed.tissues.phe[i], 1E-5);
+    }
+
+    /* and is exactly the same dive as its unpacked waypoints */
+    for (int i = 0; i < NOF_WAYPOINTS; i++)
+        waypoints[i] = unpack_waypoint(&t, &packed[i]);
+
+    init_decostate(&ds, &conf);
+    simulate_dive(&ds, waypoints, NOF_WAYPOINTS, NULL);
+
+    for (int i = 0; i < 16; i++)
+        mu_assert_double_eq(ds.tissues.pn2[i], ds_packed.tissues.pn2[i]);
+
+    free(waypoints);
+    free(packed);
+}
+
+/* a square dive to 10 + 3 * dive meters, deeper dives on trimix */
+static int container_dive(waypoint_t *wp, int dive, const gas_t *air, const gas_t *tx)
+{
+    const double depth = abs_depth(NULL, msw_to_bar(10 + 3 * dive));
+    const gas_t *gas = dive > 6 ? tx : air;
+
+    wp[0] = (waypoint_t){.depth = depth, .time = (depth - 1) / msw_to_bar(18), .gas = gas};
+    wp[1] = (waypoint_t){.depth = depth, .time = 20 + dive, .gas = gas};
+    wp[2] = (waypoint_t){.depth = abs_depth(NULL, 0), .time = (depth - 1) / msw_to_bar(9), .gas = gas};
+
+    return 3;
+}
+
+MU_TEST(test_profile_container)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t tx = gas_new(NULL, 21, 35, MOD_AUTO);
+
+    FILE *file = fopen(path, "wb");
+    profile_writer_t w;
+    waypoint_t wp[3];
+
+    mu_check(profile_writer_open(&w, file, opendeco_ctx_surface_pressure(ctx)) == 0);
+
+    /* waypoints before the first dive have nowhere to go */
+    mu_check(profile_writer_add(&w, &wp[0]) == -1);
+
+    for (int dive = 0; dive < NOF_DIVES; dive++) {
+        int n = container_dive(wp, dive, &air, &tx);
+
+        mu_check(profile_writer_dive(&w) == 0);
+
+        for (int i = 0; i < n; i++)
+            mu_check(profile_writer_add(&w, &wp[i]) == 0);
+    }
+
+    mu_check(profile_writer_close(&w) == 0);
+    fclose(file);
+
+    profile_file_t pf;
+    mu_check(profile_open(&pf, path) == 0);
+    mu_check(pf.nof_dives == NOF_DIVES);
+    mu_check(pf.gasses.nof_gasses == 2);
+    mu_assert_double_near(opendeco_ctx_surface_pressure(ctx), pf.surface_pressure, 1E-6);
+
+    /* any dive in any order, replayed straight from the mapping */
+    for (int dive = NOF_DIVES - 1; dive >= 0; dive -= 5) {
+        const packed_waypoint_t *packed;
+        int n = container_dive(wp, dive, &air, &tx);
+
+        mu_check(profile_dive(&pf, dive, &packed) == n);
+
+        decostate_t ds;
+        init_decostate(&ds, &conf);
+        simulate_dive(&ds, wp, n, NULL);
+
+        decostate_t ds_packed;
+        init_decostate(&ds_packed, &conf);
+        simulate_dive_packed(&ds_packed, &pf.gasses, packed, n, NULL);
+
+        for (int i = 0; i < 16; i++) {
+            mu_assert_double_near(ds.tissues.pn2[i], ds_packed.tissues.pn2[i], 1E-5);
+            mu_assert_double_near(ds.tissues.phe[i], ds_packed.tissues.phe[i], 1E-5);
+        }
+    }
+
+    const packed_waypoint_t *packed;
+    mu_check(profile_dive(&pf, -1, &packed) == -1);
+    mu_check(profile_dive(&pf, NOF_DIVES, &packed) == -1);
+
+    /* the same summaries with and without a pool */
+    log_archive_t serial;
+    mu_check(analyze_profile(&serial, &conf, &pf, NULL) == 0);
+    mu_check(serial.nof_dives == NOF_DIVES);
+
+    pool_t *pool = pool_new(4);
+    log_archive_t parallel;
+    mu_check(analyze_profile(&parallel, &conf, &pf, pool) == 0);
+
+    for (int dive = 0; dive < NOF_DIVES; dive++) {
+        const dive_summary_t *s = &serial.dives[dive];
+
+        mu_check(s->status == DIVE_OK);
+        mu_check(s->path == NULL);
+        mu_check(s->nof_segments == 3);
+        mu_assert_double_near(abs_depth(NULL, msw_to_bar(10 + 3 * dive)), s->max_depth, 1E-5);
+        mu_assert_double_eq(s->max_gf99, parallel.dives[dive].max_gf99);
+        mu_assert_double_eq(s->surf_gf, parallel.dives[dive].surf_gf);
+    }
+
+    /* deeper and longer dives load the diver more */
+    mu_check(serial.dives[NOF_DIVES - 1].max_gf99 > serial.dives[0].max_gf99);
+
+    /* depths converted at sea level are not replayed at altitude */
+    opendeco_ctx *altitude = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    opendeco_ctx_set_surface_pressure(altitude, 0.7);
+
+    decoconf_t altitude_conf;
+    init_decoconf(&altitude_conf, altitude, 30, 80, msw_to_bar(3));
+
+    log_archive_t mismatch;
+    mu_check(profile_surface_matches(&pf, ctx));
+    mu_check(!profile_surface_matches(&pf, altitude));
+    mu_check(analyze_profile(&mismatch, &altitude_conf, &pf, NULL) == -1);
+
+    opendeco_ctx_free(altitude);
+
+    free_log_archive(&serial);
+    free_log_archive(&parallel);
+    pool_free(pool);
+    profile_close(&pf);
+
+    /* anything but a container of this version is refused */
+    file = fopen(path, "r+b");
+    fseek(file, 8, SEEK_SET);
+    fputc(PROFILE_VERSION + 1, file);
+    fclose(file);
+
+    mu_check(profile_open(&pf, path) == -1);
+
+    file = fopen(path, "wb");
+    fputs("time,depth\n0,0\n", file);
+    fclose(file);
+
+    mu_check(profile_open(&pf, path) == -1);
+    mu_check(profile_open(&pf, "/nonexistent") == -1);
+}
+
+MU_TEST(test_convert_log)
+{
+    const gas_t ean32 = gas_new(NULL, 32, 0, MOD_AUTO);
+
+    FILE *csv = tmpfile();
+    fprintf(csv, "time,depth\n");
+
+    /* a minute at 30m in one second samples, the first one takes no time */
+    for (int s = 0; s <= 60; s++)
+        fprintf(csv, "%i,30\n", s);
+
+    fprintf(csv, "240,0\n");
+    rewind(csv);
+
+    FILE *file = fopen(path, "wb");
+    profile_writer_t w;
+    divelog_t log;
+
+    mu_check(profile_writer_open(&w, file, opendeco_ctx_surface_pressure(ctx)) == 0);
+    mu_check(init_divelog(&log, csv, ctx, &ean32) == 0);
+    mu_check(convert_log(&w, &log) == 62);
+    mu_check(profile_writer_close(&w) == 0);
+
+    free_divelog(&log);
+    fclose(csv);
+    fclose(file);
+
+    profile_file_t pf;
+    const packed_waypoint_t *packed;
+
+    mu_check(profile_open(&pf, path) == 0);
+    mu_check(pf.nof_dives == 1);
+    /* the jump to 30m at the first sample is kept without a segment */
+    mu_check(log.nof_segments == 61);
+    mu_check(profile_dive(&pf, 0, &packed) == log.nof_segments + 1);
+    mu_assert_double_eq(0, packed[0].time);
+    mu_check(gas_o2(gas_table_gas(&pf.gasses, packed[0].gas)) == 32);
+    mu_check(gas_he(gas_table_gas(&pf.gasses, packed[0].gas)) == 0);
+
+    double time = 0;
+
+    for (int i = 0; i <= log.nof_segments; i++)
+        time += packed[i].time;
+
+    mu_assert_double_near(4, time, 1E-5);
+
+    profile_close(&pf);
+}
+
+MU_TEST(test_profile_invalid_segments)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const double depth = abs_depth(NULL, msw_to_bar(20));
+
+    /* a valid dive, then a depth that is not a number, a negative time and a gas id beyond the table */
+    const waypoint_t dives[][2] = {
+        {{depth, 2, &air}, {depth, 20, &air}},
+        {{depth, 2, &air}, {NAN, 20, &air}},
+        {{depth, 2, &air}, {depth, -1, &air}},
+        {{depth, 2, &air}, {depth, 20, &air}},
+    };
+
+    FILE *file = fopen(path, "w+b");
+    profile_writer_t w;
+
+    mu_check(profile_writer_open(&w, file, opendeco_ctx_surface_pressure(ctx)) == 0);
+
+    for (int dive = 0; dive < (int) len(dives); dive++) {
+        mu_check(profile_writer_dive(&w) == 0);
+
+        for (int i = 0; i < (int) len(dives[dive]); i++)
+            mu_check(profile_writer_add(&w, &dives[dive][i]) == 0);
+    }
+
+    mu_check(profile_writer_close(&w) == 0);
+
+    /* the gas of the last segment of the last dive */
+    fseek(file, PROFILE_HEADER + 8 * sizeof(packed_waypoint_t) - 1, SEEK_SET);
+    fputc(1, file);
+    fclose(file);
+
+    profile_file_t pf;
+    const packed_waypoint_t *packed;
+
+    mu_check(profile_open(&pf, path) == 0);
+    mu_check(pf.gasses.nof_gasses == 1);
+    mu_check(profile_dive(&pf, 0, &packed) == 2);
+
+    for (int dive = 1; dive < (int) len(dives); dive++)
+        mu_check(profile_dive(&pf, dive, &packed) == -2);
+
+    log_archive_t archive;
+    mu_check(analyze_profile(&archive, &conf, &pf, NULL) == 0);
+    mu_check(archive.dives[0].status == DIVE_OK);
+
+    for (int dive = 1; dive < (int) len(dives); dive++)
+        mu_check(archive.dives[dive].status == DIVE_INVALID);
+
+    free_log_archive(&archive);
+    profile_close(&pf);
+}
+
+void testsuite_profile_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+
+    snprintf(path, sizeof(path), "/tmp/opendeco_profile_%i.odp", (int) getpid());
+}
+
+void testsuite_profile_teardown(void)
+{
+    unlink(path);
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_profile)
+{
+    MU_SUITE_CONFIGURE(&testsuite_profile_setup, &testsuite_profile_teardown);
+
+    MU_RUN_TEST(test_gas_table);
+    MU_RUN_TEST(test_simulate_dive_packed);
+    MU_RUN_TEST(test_profile_container);
+    MU_RUN_TEST(test_convert_log);
+    MU_RUN_TEST(test_profile_invalid_segments);
+}
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/pool.h"
+#include "src/replay.h"
+#include "src/schedule.h"
+
+#define NOF_SAMPLES 5000
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+static void count_calls(void *arg, int i)
+{
+    __atomic_fetch_add(&((int *) arg)[i], 1, __ATOMIC_RELAXED);
+}
+
+MU_TEST(test_pool_for)
+{
+    pool_t *pool = pool_new(4);
+    mu_check(pool != NULL);
+    mu_check(pool_threads(pool) == 4);
+
+    int calls[100] = {0};
+
+    /* the pool is reused across jobs, every index is visited exactly once per job */
+    for (int job = 1; job <= 3; job++) {
+        pool_for(pool, len(calls), &count_calls, calls);
+
+        for (int i = 0; i < (int) len(calls); i++)
+            mu_check(calls[i] == job);
+    }
+
+    pool_free(pool);
+
+    pool_for(NULL, len(calls), &count_calls, calls);
+    mu_check(calls[0] == 4 && calls[99] == 4);
+}
+
+typedef struct collect_t {
+    replay_sample_t *samples;
+    int n;
+} collect_t;
+
+static void collect_sample(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    collect_t *c = arg;
+    replay_sample_t *s = &c->samples[c->n++];
+
+    for (int i = 0; i < 16; i++) {
+        s->phe[i] = ds->tissues.phe[i];
+        s->pn2[i] = ds->tissues.pn2[i];
+    }
+
+    s->ceiling = ceiling(ds, ds->conf->gfhi);
+    s->gf99 = gf99(ds, wp.depth);
+}
+
+MU_TEST(test_replay_dive)
+{
+    const gas_t tmx = gas_new(NULL, 18, 45, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+
+    waypoint_t *waypoints = malloc(NOF_SAMPLES * sizeof(waypoint_t));
+    replay_sample_t *expected = malloc(NOF_SAMPLES * sizeof(replay_sample_t));
+    replay_sample_t *samples = malloc(NOF_SAMPLES * sizeof(replay_sample_t));
+
+    mu_check(waypoints && expected && samples);
+
+    /* a per-second log that wanders around the bottom and switches gas on the way up */
+    for (int i = 0; i < NOF_SAMPLES; i++) {
+        double msw = i < 4000 ? min(i / 3, 45 + (i / 100) % 5) : 45 - (i - 4000) * 45.0 / 1000;
+
+        waypoints[i].depth = abs_depth(NULL, msw_to_bar(msw));
+        waypoints[i].time = 1 / 60.0;
+        waypoints[i].gas = msw > 21 ? &tmx : &ean50;
+    }
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    collect_t c = {.samples = expected};
+    simulate_dive(&ds, waypoints, NOF_SAMPLES, &(waypoint_callback_t){.fn = &collect_sample, .arg = &c});
+
+    pool_t *pool = pool_new(4);
+
+    for (int run = 0; run < 2; run++) {
+        decostate_t ds_;
+        init_decostate(&ds_, &conf);
+
+        mu_check(replay_dive(&ds_, waypoints, NOF_SAMPLES, samples, run ? pool : NULL) == 0);
+
+        /* chunks start from composed operators, which round differently than the segments */
+        double err_tissues = 0;
+        double err_ceiling = 0;
+        double err_gf99 = 0;
+
+        for (int i = 0; i < NOF_SAMPLES; i++) {
+            for (int j = 0; j < 16; j++) {
+                err_tissues = max(err_tissues, fabs(expected[i].phe[j] - samples[i].phe[j]));
+                err_tissues = max(err_tissues, fabs(expected[i].pn2[j] - samples[i].pn2[j]));
+            }
+
+            err_ceiling = max(err_ceiling, fabs(expected[i].ceiling - samples[i].ceiling));
+            err_gf99 = max(err_gf99, fabs(expected[i].gf99 - samples[i].gf99));
+        }
+
+        mu_assert_double_near(0, err_tissues, 1E-10);
+        mu_assert_double_near(0, err_ceiling, 1E-10);
+        mu_assert_double_near(0, err_gf99, 1E-8);
+
+        mu_assert_double_eq(ds.max_depth, ds_.max_depth);
+        mu_assert_double_near(ds.tissues.pn2[0], ds_.tissues.pn2[0], 1E-10);
+    }
+
+    pool_free(pool);
+    free(samples);
+    free(expected);
+    free(waypoints);
+}
+
+void testsuite_replay_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+}
+
+void testsuite_replay_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_replay)
+{
+    MU_SUITE_CONFIGURE(&testsuite_replay_setup, &testsuite_replay_teardown);
+
+    MU_RUN_TEST(test_pool_for);
+    MU_RUN_TEST(test_replay_dive);
+}
@@ -0,0 +1,286 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+#include <string.h>
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/schedule.h"
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+/* deco_stop as it was implemented before the stop time solver */
+static double deco_stop_stepped(decostate_t *ds, double depth, double next_stop, double current_gf, const gas_t *gas)
+{
+    double stoplen = 0;
+
+    while (ceiling(ds, current_gf) > next_stop)
+        stoplen += add_segment_const(ds, depth, 1, gas);
+
+    return stoplen;
+}
+
+/* direct_ascent as it was implemented before the per compartment predicate */
+static int direct_ascent_copied(const decostate_t *ds, double depth, double time, const gas_t *gas)
+{
+    decostate_t ds_ = *ds;
+
+    add_segment_ascdec(&ds_, depth, abs_depth(NULL, 0), time, gas);
+
+    return gauge_depth(NULL, ceiling(&ds_, ds_.conf->gfhi)) <= 0;
+}
+
+/* calc_ndl as it was implemented before the ndl solver */
+static double calc_ndl_scanned(const decostate_t *ds, double depth, double ascrate, const gas_t *gas)
+{
+    double ndl = 0;
+    decostate_t ds_ = *ds;
+
+    while (ndl < 360) {
+        add_segment_const(&ds_, depth, 1, gas);
+
+        if (!direct_ascent(&ds_, depth, gauge_depth(NULL, depth) / ascrate, gas))
+            break;
+
+        ndl += 1;
+    }
+
+    return ndl;
+}
+
+MU_TEST(test_calc_ndl)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t tmx = gas_new(NULL, 21, 35, MOD_AUTO);
+
+    for (int d = 9; d <= 45; d += 3) {
+        double depth = abs_depth(NULL, msw_to_bar(d));
+
+        /* fresh tissues, and tissues with residual helium breathing air */
+        decostate_t ds[2];
+        init_decostate(&ds[0], &conf);
+        init_decostate(&ds[1], &conf);
+
+        add_segment_const(&ds[1], abs_depth(NULL, msw_to_bar(30)), 20, &tmx);
+        add_segment_ascdec(&ds[1], abs_depth(NULL, msw_to_bar(30)), abs_depth(NULL, 0), 3.3, &tmx);
+        add_segment_const(&ds[1], abs_depth(NULL, 0), 60, &air);
+
+        for (int i = 0; i < (int) len(ds); i++) {
+            mu_assert_double_eq(calc_ndl_scanned(&ds[i], depth, msw_to_bar(9), &air),
+                                calc_ndl(&ds[i], depth, msw_to_bar(9), &air));
+            mu_assert_double_eq(calc_ndl_scanned(&ds[i], depth, msw_to_bar(9), &tmx),
+                                calc_ndl(&ds[i], depth, msw_to_bar(9), &tmx));
+        }
+    }
+}
+
+MU_TEST(test_direct_ascent)
+{
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+    const gas_t tmx = gas_new(NULL, 21, 35, MOD_AUTO);
+    const gas_t *gasses[] = {&air, &tmx};
+
+    int passed = 0;
+    int failed = 0;
+
+    for (int g = 0; g < (int) len(gasses); g++) {
+        for (int d = 9; d <= 45; d += 3) {
+            double depth = abs_depth(NULL, msw_to_bar(d));
+
+            decostate_t ds;
+            init_decostate(&ds, &conf);
+
+            /* step through the ndl and past it */
+            for (int t = 0; t < 120; t += 5) {
+                int expected = direct_ascent_copied(&ds, depth, d / 9.0, gasses[g]);
+
+                mu_check(expected == direct_ascent(&ds, depth, d / 9.0, gasses[g]));
+
+                passed += expected;
+                failed += !expected;
+
+                add_segment_const(&ds, depth, 5, gasses[g]);
+            }
+        }
+    }
+
+    mu_check(passed > 0 && failed > 0);
+}
+
+MU_TEST(test_gas_schedule)
+{
+    gas_t gasses[GAS_SCHEDULE_GASSES + 1];
+
+    /* unsorted, with equal mods and an oxygen mod on a stop */
+    for (int i = 0; i < (int) len(gasses); i++)
+        gasses[i] = gas_new(NULL, (unsigned char[]){50, 32, 80, 50, 100, 21, 36, 28, 18}[i], 0, MOD_AUTO);
+
+    gasses[4].mod = abs_depth(NULL, msw_to_bar(6));
+
+    for (int n = 0; n <= (int) len(gasses); n++) {
+        gas_schedule_t schedule;
+        init_gas_schedule(&schedule, &conf, gasses, n);
+
+        for (double msw = 0; msw <= 80; msw += 0.25) {
+            double depth = abs_depth(NULL, msw_to_bar(msw));
+
+            mu_check(best_gas(depth, gasses, n) == gas_schedule_best(&schedule, depth));
+        }
+
+        /* either side of every mod */
+        for (int i = 0; i < n; i++) {
+            for (double d = -2E-2; d <= 2E-2; d += 5E-3) {
+                double depth = gas_mod(&gasses[i]) + d;
+
+                mu_check(best_gas(depth, gasses, n) == gas_schedule_best(&schedule, depth));
+            }
+        }
+    }
+}
+
+MU_TEST(test_deco_stop)
+{
+    const gas_t bottom = gas_new(NULL, 18, 45, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+    const gas_t air = gas_new(NULL, 21, 0, MOD_AUTO);
+
+    const gas_t *gasses[] = {&bottom, &ean50, &air};
+
+    for (int g = 0; g < (int) len(gasses); g++) {
+        decostate_t ds;
+        init_decostate(&ds, &conf);
+
+        add_segment_ascdec(&ds, abs_depth(NULL, 0), abs_depth(NULL, msw_to_bar(60)), 6, &bottom);
+        add_segment_const(&ds, abs_depth(NULL, msw_to_bar(60)), 40, &bottom);
+
+        for (int stop = 21; stop > 0; stop -= 3) {
+            double depth = abs_depth(NULL, msw_to_bar(stop));
+            double next_stop = abs_depth(NULL, msw_to_bar(stop - 3));
+
+            decostate_t ds_ = ds;
+
+            double expected = deco_stop_stepped(&ds_, depth, next_stop, 50, gasses[g]);
+            double stoplen = deco_stop(&ds, depth, next_stop, 50, gasses[g]);
+
+            mu_assert_double_eq(expected, stoplen);
+            mu_assert_double_near(ceiling(&ds_, 50), ceiling(&ds, 50), 1E-9);
+        }
+    }
+
+    /* a ceiling that no time at the stop clears ends the stop at once */
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    const tissues_t before = ds.tissues;
+
+    mu_check(isinf(deco_stop(&ds, abs_depth(NULL, msw_to_bar(3)), 0.5, 10, &air)));
+    mu_check(!memcmp(&before, &ds.tissues, sizeof(tissues_t)));
+}
+
+typedef struct ascent_check_t {
+    const gas_t *gas;
+    double time;
+    int foreign; /* segments on a gas other than the bottom gas */
+} ascent_check_t;
+
+static void check_ascent(const decostate_t *ds, waypoint_t wp, segtype_t type, void *arg)
+{
+    ascent_check_t *check = arg;
+
+    check->time += wp.time;
+    check->foreign += wp.gas != check->gas;
+}
+
+MU_TEST(test_calc_deco_no_deco_gasses)
+{
+    const gas_t ean32 = gas_new(NULL, 32, 0, MOD_AUTO);
+    const double depth = abs_depth(NULL, msw_to_bar(51));
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+
+    add_segment_ascdec(&ds, abs_depth(NULL, 0), depth, gauge_depth(NULL, depth) / msw_to_bar(9), &ean32);
+    add_segment_const(&ds, depth, 20, &ean32);
+
+    ascent_check_t check = {.gas = &ean32};
+    waypoint_callback_t wp_cb = {.fn = &check_ascent, .arg = &check};
+
+    /* the whole ascent is on the bottom gas */
+    decoinfo_t info = calc_deco(&ds, depth, &ean32, NULL, 0, &wp_cb);
+
+    mu_check(info.tts > 0 && isfinite(info.tts));
+    mu_check(check.foreign == 0);
+    mu_assert_double_near(info.tts, check.time, 1E-9);
+}
+
+MU_TEST(test_segment_ops)
+{
+    const gas_t tmx = gas_new(NULL, 18, 45, MOD_AUTO);
+    const gas_t ean50 = gas_new(NULL, 50, 0, MOD_AUTO);
+    const gas_t oxygen = gas_new(NULL, 100, 0, MOD_AUTO);
+
+    const waypoint_t waypoints[] = {
+        {.depth = abs_depth(NULL, msw_to_bar(60)), .time = 3,   .gas = &tmx   },
+        {.depth = abs_depth(NULL, msw_to_bar(60)), .time = 25,  .gas = &tmx   },
+        {.depth = abs_depth(NULL, msw_to_bar(21)), .time = 4.3, .gas = &tmx   },
+        {.depth = abs_depth(NULL, msw_to_bar(21)), .time = 2,   .gas = &ean50 },
+        {.depth = abs_depth(NULL, msw_to_bar(6)),  .time = 1.7, .gas = &ean50 },
+        {.depth = abs_depth(NULL, msw_to_bar(6)),  .time = 17,  .gas = &oxygen},
+    };
+
+    decostate_t ds[2];
+    init_decostate(&ds[0], &conf);
+    init_decostate(&ds[1], &conf);
+
+    simulate_dive(&ds[0], waypoints, len(waypoints), NULL);
+
+    /* the whole profile collapses into a single operator */
+    segment_op_t op;
+    segment_op_identity(&op);
+
+    double depth = abs_depth(NULL, 0);
+
+    for (int i = 0; i < (int) len(waypoints); i++) {
+        segment_op_t wp;
+        segment_op_waypoint(&wp, conf.model, depth, &waypoints[i]);
+        segment_op_compose(&op, &op, &wp);
+
+        depth = waypoints[i].depth;
+    }
+
+    apply_segment_op(&ds[1], &op);
+
+    for (int i = 0; i < 16; i++) {
+        mu_assert_double_eq(ds[0].tissues.phe[i], ds[1].tissues.phe[i]);
+        mu_assert_double_eq(ds[0].tissues.pn2[i], ds[1].tissues.pn2[i]);
+    }
+
+    mu_check(ds[1].tissues.he_loaded);
+    mu_assert_double_eq(ds[0].max_depth, ds[1].max_depth);
+    mu_assert_double_eq(ceiling(&ds[0], 50), ceiling(&ds[1], 50));
+}
+
+void testsuite_schedule_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 80, msw_to_bar(3));
+}
+
+void testsuite_schedule_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_schedule)
+{
+    MU_SUITE_CONFIGURE(&testsuite_schedule_setup, &testsuite_schedule_teardown);
+
+    MU_RUN_TEST(test_calc_ndl);
+    MU_RUN_TEST(test_direct_ascent);
+    MU_RUN_TEST(test_gas_schedule);
+    MU_RUN_TEST(test_deco_stop);
+    MU_RUN_TEST(test_calc_deco_no_deco_gasses);
+    MU_RUN_TEST(test_segment_ops);
+}
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/pool.h"
+#include "src/schedule.h"
+#include "src/sweep.h"
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+MU_TEST(test_gf_sweep)
+{
+    const gas_t tmx = gas_new(NULL, 18, 35, MOD_AUTO);
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 50, 0, MOD_AUTO),
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    const double depth = abs_depth(NULL, msw_to_bar(50));
+
+    decostate_t ds;
+    init_decostate(&ds, &conf);
+    add_segment_ascdec(&ds, abs_depth(NULL, 0), depth, gauge_depth(NULL, depth) / msw_to_bar(9), &tmx);
+    add_segment_const(&ds, depth, 25, &tmx);
+
+    const int gflo[] = {10, 30, 50, 70, 90};
+    const int gfhi[] = {50, 70, 85, 100};
+
+    pool_t *pool = pool_new(3);
+    gf_sweep_t sweep[2];
+
+    mu_check(gf_sweep(&sweep[0], &ds, depth, &tmx, gflo, len(gflo), gfhi, len(gfhi), deco_gasses, 2, NULL) == 0);
+    mu_check(gf_sweep(&sweep[1], &ds, depth, &tmx, gflo, len(gflo), gfhi, len(gfhi), deco_gasses, 2, pool) == 0);
+
+    /* every combination matches a plan for those gradient factors */
+    for (int lo = 0; lo < (int) len(gflo); lo++) {
+
+        for (int hi = 0; hi < (int) len(gfhi); hi++) {
+            const decoinfo_t *info = gf_sweep_info(&sweep[0], lo, hi);
+
+            if (gflo[lo] > gfhi[hi]) {
+                mu_check(info->tts == -1);
+                continue;
+            }
+
+            decoconf_t c;
+            init_decoconf(&c, ctx, gflo[lo], gfhi[hi], conf.ceil_multiple);
+
+            decostate_t expected = ds;
+            expected.conf = &c;
+
+            mu_check(calc_deco(&expected, depth, &tmx, deco_gasses, 2, NULL).tts == info->tts);
+
+            /* the shared ascent stops where every plan of the gf low does */
+            mu_check(expected.firststop == -1 || expected.firststop == sweep[0].firststop[lo]);
+        }
+    }
+
+    /* the most and least conservative corners */
+    mu_check(gf_sweep_info(&sweep[0], 0, 0)->tts > gf_sweep_info(&sweep[0], len(gflo) - 1, len(gfhi) - 1)->tts);
+
+    /* the pool only changes the order of evaluation */
+    for (int i = 0; i < (int) (len(gflo) * len(gfhi)); i++)
+        mu_check(sweep[0].info[i].tts == sweep[1].info[i].tts);
+
+    free_gf_sweep(&sweep[0]);
+    free_gf_sweep(&sweep[1]);
+    pool_free(pool);
+}
+
+void testsuite_sweep_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 75, msw_to_bar(3));
+}
+
+void testsuite_sweep_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_sweep)
+{
+    MU_SUITE_CONFIGURE(&testsuite_sweep_setup, &testsuite_sweep_teardown);
+
+    MU_RUN_TEST(test_gf_sweep);
+}
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: MIT-0 */
+
+#include <math.h>
+
+#include "minunit/minunit.h"
+
+#include "src/deco.h"
+#include "src/pool.h"
+#include "src/schedule.h"
+#include "src/table.h"
+
+static opendeco_ctx *ctx;
+static decoconf_t conf;
+
+MU_TEST(test_dive_table)
+{
+    const gas_t ean32 = gas_new(NULL, 32, 0, MOD_AUTO);
+    const gas_t deco_gasses[] = {
+        gas_new(NULL, 100, 0, abs_depth(NULL, msw_to_bar(6))),
+    };
+
+    double depths[6];
+    double times[8];
+
+    for (int d = 0; d < (int) len(depths); d++)
+        depths[d] = abs_depth(NULL, msw_to_bar(12 + 4 * d));
+
+    for (int t = 0; t < (int) len(times); t++)
+        times[t] = 10 * (t + 1);
+
+    pool_t *pool = pool_new(3);
+    dive_table_t table[2];
+
+    mu_check(dive_table(&table[0], &conf, depths, len(depths), times, len(times), &ean32, deco_gasses, 1, NULL) == 0);
+    mu_check(dive_table(&table[1], &conf, depths, len(depths), times, len(times), &ean32, deco_gasses, 1, pool) == 0);
+
+    /* every cell only differs from a dive planned from scratch by rounding */
+    double max_err = 0;
+
+    for (int d = 0; d < (int) len(depths); d++) {
+        const double descent_time = gauge_depth(NULL, depths[d]) / msw_to_bar(9);
+
+        for (int t = 0; t < (int) len(times); t++) {
+            decostate_t ds;
+            init_decostate(&ds, &conf);
+            add_segment_ascdec(&ds, abs_depth(NULL, 0), depths[d], descent_time, &ean32);
+            add_segment_const(&ds, depths[d], times[t] - descent_time, &ean32);
+
+            decoinfo_t expected = calc_deco(&ds, depths[d], &ean32, deco_gasses, 1, NULL);
+            const decoplan_t *plan = dive_table_plan(&table[0], d, t);
+
+            max_err = max(max_err, fabs(expected.tts - plan->info.tts));
+            max_err = max(max_err, fabs(expected.ndl - plan->info.ndl));
+        }
+    }
+
+    mu_assert_double_near(0, max_err, 1E-9);
+
+    /* no deco is required up to the ndl, but is a minute later */
+    for (int d = 0; d < (int) len(depths); d++) {
+        for (int t = 0; t < (int) len(times); t++) {
+            const decoplan_t *plan = dive_table_plan(&table[0], d, t);
+
+            if (times[t] <= table[0].ndl[d])
+                mu_check(plan->nof_stops == 0);
+            else if (times[t] >= table[0].ndl[d] + 1)
+                mu_check(plan->nof_stops > 0);
+        }
+    }
+
+    /* the deepest rows require deco within the table, the shallowest never do */
+    mu_check(table[0].ndl[0] > times[len(times) - 1]);
+    mu_check(table[0].ndl[len(depths) - 1] < times[len(times) - 1]);
+
+    /* the pool only changes the order of evaluation */
+    for (int i = 0; i < (int) (len(depths) * len(times)); i++) {
+        mu_check(table[0].plans[i].info.tts == table[1].plans[i].info.tts);
+        mu_check(table[0].plans[i].nof_stops == table[1].plans[i].nof_stops);
+    }
+
+    free_dive_table(&table[0]);
+    free_dive_table(&table[1]);
+    pool_free(pool);
+}
+
+MU_TEST(test_dive_table_ndl_max)
+{
+    const gas_t ean32 = gas_new(NULL, 32, 0, MOD_AUTO);
+    const double depths[] = {abs_depth(NULL, msw_to_bar(9)), abs_depth(NULL, msw_to_bar(12))};
+    const double times[] = {10};
+
+    dive_table_t table;
+    mu_check(dive_table(&table, &conf, depths, len(depths), times, len(times), &ean32, NULL, 0, NULL) == 0);
+
+    /* at 9m no deco is required within NDL_MAX, which is not a runtime to print */
+    mu_check(isinf(table.ndl[0]));
+    mu_check(isfinite(table.ndl[1]) && table.ndl[1] > times[0]);
+
+    free_dive_table(&table);
+}
+
+void testsuite_table_setup(void)
+{
+    ctx = opendeco_ctx_new(ZHL_16C, P_WV_BUHL);
+    init_decoconf(&conf, ctx, 30, 75, msw_to_bar(3));
+}
+
+void testsuite_table_teardown(void)
+{
+    opendeco_ctx_free(ctx);
+}
+
+MU_TEST_SUITE(testsuite_table)
+{
+    MU_SUITE_CONFIGURE(&testsuite_table_setup, &testsuite_table_teardown);
+
+    MU_RUN_TEST(test_dive_table);
+    MU_RUN_TEST(test_dive_table_ndl_max);
+}